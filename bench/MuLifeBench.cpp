@@ -0,0 +1,361 @@
+// =====================================================================
+//        BENCHMARK DEGLI STADI DELL'ANALISI (Google Benchmark)
+// =====================================================================
+//
+// Misura separatamente, su ogni presa dati di data/Take e su versioni
+// ingrandite 10× e 100× di Take8:
+//
+//   Parse    testo "CH CT" → CH, CT          (ParseFifoText, file in memoria)
+//   Decode   reset e tempo assoluto         (FifoDecoder → EventStore)
+//   Pair     START → STOP                   (PairingEngine)
+//   Fill     istogrammi dt totale e per PMT (DecaySpectra)
+//   Fit      fit unbinned esponenziale + fondo (FitLifetimeUnbinned)
+//   Pulses   ricerca degli impulsi nei record wavedump (WavePulses.h),
+//            scalare e AVX2, sul file --wave (campioni/s in items_per_second)
+//
+// Per ogni stadio sono riportati:
+//   items_per_second  elementi dello stadio (righe, eventi o coppie) al secondo
+//   records/s         righe del file equivalenti al secondo (confrontabile
+//                     tra stadi: quanto file al secondo reggerebbe lo stadio)
+//   peakRSS_MB        picco di memoria residente del processo fino a lì
+//                     (getrusage: non scende, quindi è il massimo sui
+//                     dataset già visti; in memoria ne resta uno alla volta)
+//
+// Le prese ingrandite ripetono Take8 più volte di seguito: le copie dopo
+// la prima ripartono dal primo reset, così i tempi restano crescenti come
+// in una presa dati lunga. Sono costruite in memoria solo quando serve.
+//
+// Compilazione ed esecuzione (dalla radice del repository):
+//   cmake -S . -B build && cmake --build build --target MuLifeBench
+//   ./build/MuLifeBench                                  (tutto)
+//   ./build/MuLifeBench --benchmark_filter='Pair/Take8'  (solo un caso)
+//   ./build/MuLifeBench --data=data/Take --scales=10,100,1000
+//   ./build/MuLifeBench --wave=data/wavedump/PlotData.txt --benchmark_filter=Pulses
+// =====================================================================
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include <benchmark/benchmark.h>
+
+#include "MuLife.h"
+
+using namespace mulife;
+
+namespace {
+
+// Presa dati preparata per tutti gli stadi (ogni stadio parte dal
+// risultato del precedente, calcolato una volta sola)
+struct Dataset {
+    std::string               text;       // file in formato testo
+    std::vector<unsigned int> CH, CT;
+    EventStore                events;
+    std::vector<DecayPair>    pairs;
+    std::vector<double>       dt;         // dt delle coppie [µs]
+};
+
+struct Source {
+    std::string path;    // file di data/Take
+    int         scale;   // ripetizioni
+};
+
+std::string              g_dataDir = "data/Take";
+std::vector<int>         g_scales  = {10, 100};
+std::string              g_wavePath = "data/wavedump/PlotData.txt";
+std::map<std::string, Source>                   g_sources;
+std::map<std::string, std::unique_ptr<Dataset>> g_cache;
+
+const PairingParams g_params;
+const int           NBINS = 80;
+
+bool ReadText(const char* path, std::string& out)
+{
+    std::FILE* f = std::fopen(path, "rb");
+    if (f == nullptr) return false;
+    char buf[1 << 16];
+    std::size_t n;
+    while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) out.append(buf, n);
+    std::fclose(f);
+    return true;
+}
+
+// scale copie di CH/CT; dalla seconda in poi si riparte dal primo reset
+void Replicate(std::vector<unsigned int>& CH, std::vector<unsigned int>& CT, int scale)
+{
+    std::size_t first = 0;
+    while (first < CH.size() && !IsResetWord(CH[first])) ++first;
+    const std::size_t n = CH.size();
+    CH.reserve(n + (std::size_t)(scale - 1) * (n - first));
+    CT.reserve(CH.capacity());
+    for (int k = 1; k < scale; ++k) {
+        CH.insert(CH.end(), CH.begin() + first, CH.begin() + n);
+        CT.insert(CT.end(), CT.begin() + first, CT.begin() + n);
+    }
+}
+
+std::string FormatText(const std::vector<unsigned int>& CH, const std::vector<unsigned int>& CT)
+{
+    std::string text;
+    text.reserve(CH.size() * 16);
+    char line[32];
+    for (std::size_t i = 0; i < CH.size(); ++i) {
+        int len = std::snprintf(line, sizeof(line), "%u %u\n", CH[i], CT[i]);
+        text.append(line, (std::size_t)len);
+    }
+    return text;
+}
+
+// Dataset del nome dato (costruito al primo uso), nullptr se il file manca
+const Dataset* GetDataset(const std::string& name)
+{
+    auto it = g_cache.find(name);
+    if (it != g_cache.end()) return it->second.get();
+
+    // i benchmark di un dataset sono consecutivi: in memoria ne resta uno solo
+    g_cache.clear();
+
+    const Source& src = g_sources.at(name);
+    std::unique_ptr<Dataset> d(new Dataset);
+    if (!ReadText(src.path.c_str(), d->text)) return nullptr;
+
+    ParseFifoText(d->text.data(), d->text.data() + d->text.size(), d->CH, d->CT);
+    if (src.scale > 1) {
+        Replicate(d->CH, d->CT, src.scale);
+        d->text = FormatText(d->CH, d->CT);
+    }
+
+    FifoDecoder decoder;
+    decoder.Decode(d->CH.data(), d->CT.data(), d->CH.size(), d->events);
+
+    PairingEngine engine(g_params);
+    engine.Process(d->events, d->pairs);
+    engine.Finish(d->pairs);
+
+    d->dt.reserve(d->pairs.size());
+    for (const DecayPair& p : d->pairs) d->dt.push_back((double)p.dtTicks * g_params.tickUs);
+
+    const Dataset* out = d.get();
+    g_cache[name] = std::move(d);
+    return out;
+}
+
+double PeakRssMB()
+{
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return (double)ru.ru_maxrss / 1024.0;   // ru_maxrss in kB su Linux
+}
+
+void SetCounters(benchmark::State& state, const Dataset& d, std::size_t items)
+{
+    state.SetItemsProcessed((std::int64_t)(state.iterations() * items));
+    state.counters["records/s"] =
+        benchmark::Counter((double)d.CH.size(), benchmark::Counter::kIsIterationInvariantRate);
+    state.counters["peakRSS_MB"] = PeakRssMB();
+}
+
+// ---------------------------------------------------------------------
+//                               Stadi
+// ---------------------------------------------------------------------
+
+void BM_Parse(benchmark::State& state, std::string name)
+{
+    const Dataset* d = GetDataset(name);
+    if (d == nullptr) { state.SkipWithError("file non trovato"); return; }
+
+    std::vector<unsigned int> CH, CT;
+    for (auto _ : state) {
+        CH.clear();
+        CT.clear();
+        ParseFifoText(d->text.data(), d->text.data() + d->text.size(), CH, CT);
+        benchmark::DoNotOptimize(CH.data());
+        benchmark::DoNotOptimize(CT.data());
+    }
+    state.SetBytesProcessed((std::int64_t)(state.iterations() * d->text.size()));
+    SetCounters(state, *d, d->CH.size());
+}
+
+void BM_Decode(benchmark::State& state, std::string name)
+{
+    const Dataset* d = GetDataset(name);
+    if (d == nullptr) { state.SkipWithError("file non trovato"); return; }
+
+    EventStore events;
+    events.reserve(d->CH.size());
+    for (auto _ : state) {
+        events.clear();
+        FifoDecoder decoder;
+        decoder.Decode(d->CH.data(), d->CT.data(), d->CH.size(), events);
+        benchmark::DoNotOptimize(events.ticks.data());
+    }
+    SetCounters(state, *d, d->CH.size());
+}
+
+void BM_Pair(benchmark::State& state, std::string name)
+{
+    const Dataset* d = GetDataset(name);
+    if (d == nullptr) { state.SkipWithError("file non trovato"); return; }
+
+    std::vector<DecayPair> pairs;
+    pairs.reserve(d->pairs.size());
+    for (auto _ : state) {
+        pairs.clear();
+        PairingEngine engine(g_params);
+        engine.Process(d->events, pairs);
+        engine.Finish(pairs);
+        benchmark::DoNotOptimize(pairs.data());
+    }
+    SetCounters(state, *d, d->events.size());
+}
+
+void BM_Fill(benchmark::State& state, std::string name)
+{
+    const Dataset* d = GetDataset(name);
+    if (d == nullptr) { state.SkipWithError("file non trovato"); return; }
+
+    DecaySpectra spectra(NBINS, g_params.tmin, g_params.tmax);
+    for (auto _ : state) {
+        spectra.Reset();
+        for (const DecayPair& p : d->pairs) spectra.Fill((double)p.dtTicks * g_params.tickUs, p.stopBlocks);
+        benchmark::DoNotOptimize(&spectra);
+    }
+    SetCounters(state, *d, d->pairs.size());
+}
+
+void BM_Fit(benchmark::State& state, std::string name)
+{
+    const Dataset* d = GetDataset(name);
+    if (d == nullptr) { state.SkipWithError("file non trovato"); return; }
+    if (d->dt.empty()) { state.SkipWithError("nessuna coppia da fittare"); return; }
+
+    LifetimeFitResult res;
+    for (auto _ : state) {
+        FitLifetimeUnbinned(d->dt, g_params.tmin, g_params.tmax, res);
+        benchmark::DoNotOptimize(&res);
+    }
+    state.counters["iterazioni"] = res.iterations;
+    SetCounters(state, *d, d->dt.size());
+}
+
+// Record del file wavedump (letti una volta sola), vuoto se il file manca
+const std::vector<WaveRecord>& WaveRecords()
+{
+    static std::vector<WaveRecord> records;
+    static bool loaded = false;
+    if (!loaded) {
+        loaded = true;
+        WavedumpReader in;
+        WaveRecord     rec;
+        if (in.Open(g_wavePath.c_str())) {
+            while (in.Next(rec)) records.push_back(rec);
+        }
+    }
+    return records;
+}
+
+void BM_Pulses(benchmark::State& state, bool useSimd)
+{
+    const std::vector<WaveRecord>& records = WaveRecords();
+    if (records.empty()) { state.SkipWithError("file wavedump non trovato"); return; }
+
+    std::size_t samples = 0;
+    for (const WaveRecord& r : records) samples += r.size();
+
+    std::vector<WaveHit> hits;
+    for (auto _ : state) {
+        hits.clear();
+        for (const WaveRecord& r : records) FindWavePulses(r.samples.data(), r.size(), PulseConfig(), hits, useSimd);
+        benchmark::DoNotOptimize(hits.data());
+    }
+    state.SetItemsProcessed((std::int64_t)(state.iterations() * samples));
+    state.counters["impulsi"]    = (double)hits.size();
+    state.counters["peakRSS_MB"] = PeakRssMB();
+}
+
+// ---------------------------------------------------------------------
+//                     Opzioni e registrazione
+// ---------------------------------------------------------------------
+
+// Toglie da argv le opzioni --data=DIR, --scales=a,b,... e --wave=FILE; il resto
+// passa a Google Benchmark
+void ParseOwnOptions(int& argc, char** argv)
+{
+    int out = 1;
+    for (int k = 1; k < argc; ++k) {
+        if (std::strncmp(argv[k], "--data=", 7) == 0) {
+            g_dataDir = argv[k] + 7;
+        } else if (std::strncmp(argv[k], "--wave=", 7) == 0) {
+            g_wavePath = argv[k] + 7;
+        } else if (std::strncmp(argv[k], "--scales=", 9) == 0) {
+            g_scales.clear();
+            for (const char* p = argv[k] + 9; *p != '\0';) {
+                char* q;
+                long s = std::strtol(p, &q, 10);
+                if (q == p) break;
+                if (s > 1) g_scales.push_back((int)s);
+                p = (*q == ',') ? q + 1 : q;
+            }
+        } else {
+            argv[out++] = argv[k];
+        }
+    }
+    argc = out;
+}
+
+void RegisterAll()
+{
+    static const char* const TAKES[] = {"Take0", "Take1", "Take3", "Take4",
+                                        "Take5", "Take7", "Take8"};
+    benchmark::RegisterBenchmark("Pulses/scalar", BM_Pulses, false)->Unit(benchmark::kMicrosecond);
+    benchmark::RegisterBenchmark("Pulses/avx2",   BM_Pulses, true)->Unit(benchmark::kMicrosecond);
+
+    std::vector<std::string> names;
+    for (const char* t : TAKES) {
+        std::string path = g_dataDir + "/FIFOread_" + t + ".txt";
+        if (std::FILE* f = std::fopen(path.c_str(), "rb")) {
+            std::fclose(f);
+            g_sources[t] = Source{path, 1};
+            names.push_back(t);
+        }
+    }
+    if (g_sources.count("Take8") != 0) {
+        for (int s : g_scales) {
+            std::string name = "Take8x" + std::to_string(s);
+            g_sources[name] = Source{g_sources["Take8"].path, s};
+            names.push_back(name);
+        }
+    }
+    if (names.empty()) {
+        std::fprintf(stderr, "[ERRORE] Nessuna presa dati in %s\n", g_dataDir.c_str());
+        return;
+    }
+
+    for (const std::string& n : names) {
+        benchmark::RegisterBenchmark(("Parse/" + n).c_str(),  BM_Parse,  n)->Unit(benchmark::kMillisecond);
+        benchmark::RegisterBenchmark(("Decode/" + n).c_str(), BM_Decode, n)->Unit(benchmark::kMillisecond);
+        benchmark::RegisterBenchmark(("Pair/" + n).c_str(),   BM_Pair,   n)->Unit(benchmark::kMillisecond);
+        benchmark::RegisterBenchmark(("Fill/" + n).c_str(),   BM_Fill,   n)->Unit(benchmark::kMicrosecond);
+        benchmark::RegisterBenchmark(("Fit/" + n).c_str(),    BM_Fit,    n)->Unit(benchmark::kMicrosecond);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    ParseOwnOptions(argc, argv);
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+
+    RegisterAll();
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
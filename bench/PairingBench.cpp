@@ -0,0 +1,217 @@
+// =====================================================================
+//            MICROBENCHMARK: PAIRING SU ARRAY DI STRUCT vs SoA
+// =====================================================================
+//
+// Confronta il loop di pairing originale di Mu_life_new (vettore di
+// struct Event + CollectBlockMask) con PairingEngine su EventStore
+// (structure of arrays + bitmap dei candidati), sugli stessi eventi già
+// decodificati. Stampa eventi/secondo per entrambi e verifica che le
+// coppie coincidano; per confronto misura anche il pre-passaggio delle
+// bitmap (scalare e AVX2) e la lettura del file.
+//
+// Compilazione ed esecuzione (dalla radice del repository):
+//   g++ -O2 -std=c++17 -Isrc bench/PairingBench.cpp -o PairingBench
+//   ./PairingBench data/Take/FIFOread_Take8.txt 200
+// =====================================================================
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "PairingEngine.h"
+
+using namespace mulife;
+
+namespace legacy {
+
+// Copia del layout e del loop di Mu_life5.cpp prima dell'EventStore
+// (tempo in µs come double)
+struct Event {
+    std::size_t index;
+    double      t_us;
+    unsigned int ch;
+    bool isStart;
+    bool isStop;
+    unsigned int stopMask;
+
+    Event(std::size_t i, double t, unsigned int c)
+        : index(i), t_us(t), ch(c),
+          isStart((c & BIT_START) != 0u),
+          isStop((c & STOP_GENERIC_MASK) != 0u),
+          stopMask(c & STOP_GENERIC_MASK) {}
+};
+
+struct DecayPair {
+    double       dt;
+    unsigned int startBlocks;
+    unsigned int stopBlocks;
+    std::size_t  startRow;
+    std::size_t  stopRow;
+};
+
+unsigned int CollectBlockMask(const std::vector<Event>& evs, int centerIndex, int halfWindow)
+{
+    unsigned int mask = 0u;
+    int iMin = std::max(0, centerIndex - halfWindow);
+    int iMax = std::min((int)evs.size() - 1, centerIndex + halfWindow);
+    for (int i = iMin; i <= iMax; ++i) mask |= (evs[i].ch & BLOCK_MASK);
+    return mask;
+}
+
+void Pair(const std::vector<Event>& events, const PairingParams& P, std::vector<DecayPair>& out)
+{
+    std::size_t N = events.size();
+    std::size_t i = 0;
+    while (i < N) {
+        const Event& evStart = events[i];
+        if (!evStart.isStart) { ++i; continue; }
+
+        std::size_t idxStart = i;
+        double tStart = evStart.t_us;
+        bool discardThisStart = false;
+
+        bool foundEarlyStop = false;
+        std::size_t idxEarlyStop = 0;
+        for (std::size_t j = idxStart + 1; j < N && j <= idxStart + (std::size_t)P.earlyStopMaxEvents; ++j) {
+            if (events[j].isStart) { i = j; discardThisStart = true; break; }
+            if ((events[j].stopMask & STOP_GENERIC_MASK) != 0u) { foundEarlyStop = true; idxEarlyStop = j; break; }
+        }
+        if (discardThisStart) continue;
+        if (!foundEarlyStop) { ++i; continue; }
+
+        unsigned int earlyBlockMask = CollectBlockMask(events, (int)idxEarlyStop, P.earlyBlockWindow);
+
+        bool foundFinalStop = false;
+        std::size_t idxFinalStop = 0;
+        for (std::size_t j = idxEarlyStop + 1; j < N; ++j) {
+            if (events[j].t_us - tStart > P.finalStopMaxUs) break;
+            if (events[j].isStart) { i = j; discardThisStart = true; break; }
+            if ((events[j].ch & BIT_STOP) != 0u) { foundFinalStop = true; idxFinalStop = j; break; }
+        }
+        if (discardThisStart) continue;
+        if (!foundFinalStop) { ++i; continue; }
+
+        double dt = events[idxFinalStop].t_us - tStart;
+        if (dt >= P.tmin && dt <= P.tmax) {
+            DecayPair p;
+            p.dt          = dt;
+            p.startBlocks = earlyBlockMask;
+            p.stopBlocks  = CollectBlockMask(events, (int)idxFinalStop, P.finalBlockWindow);
+            p.startRow    = events[idxStart].index;
+            p.stopRow     = events[idxFinalStop].index;
+            out.push_back(p);
+        }
+        i = idxFinalStop + 1;
+    }
+}
+
+} // namespace legacy
+
+template <class Fn>
+double BestSeconds(int repeat, Fn&& fn)
+{
+    double best = 1e30;
+    for (int r = 0; r < repeat; ++r) {
+        auto t0 = std::chrono::steady_clock::now();
+        fn();
+        auto t1 = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double>(t1 - t0).count());
+    }
+    return best;
+}
+
+int main(int argc, char** argv)
+{
+    const char* path = (argc > 1) ? argv[1] : "data/Take/FIFOread_Take8.txt";
+    int repeat = (argc > 2) ? std::atoi(argv[2]) : 200;
+
+    std::vector<unsigned int> CH, CT;
+    if (!LoadFifo(path, CH, CT)) {
+        std::fprintf(stderr, "[ERRORE] Impossibile aprire il file %s\n", path);
+        return 1;
+    }
+
+    EventStore store;
+    FifoDecoder decoder;
+    decoder.Decode(CH.data(), CT.data(), CH.size(), store);
+
+    std::vector<legacy::Event> events;
+    events.reserve(store.size());
+    for (std::size_t k = 0; k < store.size(); ++k) events.emplace_back(store.row[k], (double)store.ticks[k] * tick_us, store.ch[k]);
+
+    PairingParams params;
+    std::vector<legacy::DecayPair> a;
+    std::vector<DecayPair>         b;
+
+    double tLegacy = BestSeconds(repeat, [&] {
+        a.clear();
+        legacy::Pair(events, params, a);
+    });
+    double tSoA = BestSeconds(repeat, [&] {
+        b.clear();
+        PairingEngine engine(params);
+        engine.Process(store, b);
+        engine.Finish(b);
+    });
+
+    // decodifica + pairing, come in un passaggio reale su un file
+    double tLegacyFull = BestSeconds(repeat, [&] {
+        std::vector<legacy::Event> evs;
+        evs.reserve(CH.size());
+        long long n_reset = -1;
+        bool seenFirstReset = false;
+        for (std::size_t i = 0; i < CH.size(); ++i) {
+            unsigned int ch = CH[i];
+            if (IsResetWord(ch)) { seenFirstReset = true; n_reset += 1; continue; }
+            if (!seenFirstReset) continue;
+            if ((ch & (BIT_START | STOP_GENERIC_MASK)) == 0u) continue;
+            double t_us = (double)(CT[i] & COUNTER_MASK) * tick_us + (double)n_reset * reset_t_us;
+            evs.emplace_back(i, t_us, ch);
+        }
+        a.clear();
+        legacy::Pair(evs, params, a);
+    });
+    double tSoAFull = BestSeconds(repeat, [&] {
+        EventStore st;
+        st.reserve(CH.size());
+        FifoDecoder dec;
+        dec.Decode(CH.data(), CT.data(), CH.size(), st);
+        b.clear();
+        PairingEngine engine(params);
+        engine.Process(st, b);
+        engine.Finish(b);
+    });
+
+    bool same = a.size() == b.size();
+    for (std::size_t k = 0; same && k < a.size(); ++k) {
+        same = std::fabs(a[k].dt - (double)b[k].dtTicks * params.tickUs) < 1e-4 && a[k].startBlocks == b[k].startBlocks &&
+               a[k].stopBlocks == b[k].stopBlocks && a[k].startRow == b[k].startRow;
+    }
+
+    EventBitmaps bits;
+    double tBitsScalar = BestSeconds(repeat, [&] { BuildEventBitmaps(store.ch.data(), store.size(), bits, false); });
+    double tBitsSimd   = BestSeconds(repeat, [&] { BuildEventBitmaps(store.ch.data(), store.size(), bits, true); });
+    double tLoad = BestSeconds(std::max(repeat / 10, 1), [&] {
+        std::vector<unsigned int> ch, ct;
+        LoadFifo(path, ch, ct);
+    });
+
+    const double n = (double)store.size();
+    std::printf("File            : %s\n", path);
+    std::printf("Eventi          : %zu   coppie: %zu   (%s)\n", store.size(), b.size(),
+                same ? "coppie identiche" : "COPPIE DIVERSE");
+    std::printf("Solo pairing (eventi già decodificati)\n");
+    std::printf("  Array di struct : %8.3f ms   %8.1f Meventi/s\n", tLegacy * 1e3, n / tLegacy * 1e-6);
+    std::printf("  EventStore (SoA): %8.3f ms   %8.1f Meventi/s\n", tSoA * 1e3, n / tSoA * 1e-6);
+    std::printf("Decodifica + pairing\n");
+    std::printf("  Array di struct : %8.3f ms   %8.1f Meventi/s\n", tLegacyFull * 1e3, n / tLegacyFull * 1e-6);
+    std::printf("  EventStore (SoA): %8.3f ms   %8.1f Meventi/s\n", tSoAFull * 1e3, n / tSoAFull * 1e-6);
+    std::printf("Pre-passaggio bitmap\n");
+    std::printf("  scalare         : %8.3f ms   %8.1f Meventi/s\n", tBitsScalar * 1e3, n / tBitsScalar * 1e-6);
+    std::printf("  SIMD (AVX2)     : %8.3f ms   %8.1f Meventi/s\n", tBitsSimd * 1e3, n / tBitsSimd * 1e-6);
+    std::printf("Lettura del file (LoadFifo): %8.3f ms\n", tLoad * 1e3);
+    return same ? 0 : 1;
+}
@@ -0,0 +1,280 @@
+#ifndef MULIFE_CHANNELSKEW_H
+#define MULIFE_CHANNELSKEW_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cmath>
+#include <deque>
+#include <ostream>
+#include <vector>
+
+#include "EventBitmaps.h"
+#include "FifoBinary.h"
+#include "Histogram.h"
+#include "MuDecoding.h"
+
+// =====================================================================
+//             MATRICE DEI RITARDI TRA I CANALI (skew)
+// =====================================================================
+//
+// Generalizza Delay in DEONANO.cpp (solo CH == 2 seguito da CH == 1):
+// per ogni coppia ordinata di bit di canale
+//
+//   0 START, 1 STOP, 2 PMT8, 3 PMT9, 4 PMT10, 5 PMT11
+//
+// raccoglie la distribuzione di dt = t(to) - t(from), in tick, per
+// tutti gli eventi entro ±windowTicks l'uno dall'altro, non solo tra
+// righe adiacenti. Due bit nella stessa riga contano con dt = 0; un
+// evento non è mai confrontato con se stesso, quindi sulla diagonale
+// ci sono solo righe diverse con lo stesso bit.
+//
+// Un solo passaggio in avanti sugli eventi decodificati (tempo assoluto
+// in tick, vedi MuDecoding.h): gli eventi degli ultimi windowTicks tick
+// restano in una piccola coda e ogni nuovo evento è confrontato solo
+// con quelli. Le distribuzioni sono conteggi per tick intero in
+// [-windowTicks, windowTicks], esatte; il picco di (STOP, PMTk) è il
+// ritardo del PMT k da correggere nel pairing.
+// =====================================================================
+
+namespace mulife {
+
+const int       SKEW_CHANNELS     = 6;
+const long long SKEW_WINDOW_TICKS = 16;   // finestra di default [tick]
+
+inline const char* SkewChannelName(int c)
+{
+    static const char* const names[SKEW_CHANNELS] = {"START", "STOP", "PMT8", "PMT9", "PMT10", "PMT11"};
+    return (c >= 0 && c < SKEW_CHANNELS) ? names[c] : "?";
+}
+
+class SkewMatrix {
+public:
+    explicit SkewMatrix(long long windowTicks = SKEW_WINDOW_TICKS)
+        : window_(windowTicks > 0 ? windowTicks : 0),
+          counts_((std::size_t)(SKEW_CHANNELS * SKEW_CHANNELS) * (std::size_t)(2 * window_ + 1), 0u) {}
+
+    void Fill(int from, int to, long long dt)
+    {
+        if (dt < -window_ || dt > window_) return;
+        ++counts_[Offset(from, to) + (std::size_t)(dt + window_)];
+    }
+
+    void Add(const SkewMatrix& o)
+    {
+        if (o.window_ != window_) return;
+        for (std::size_t k = 0; k < counts_.size(); ++k) counts_[k] += o.counts_[k];
+    }
+
+    long long Window() const { return window_; }
+
+    std::uint64_t Count(int from, int to, long long dt) const
+    {
+        if (dt < -window_ || dt > window_) return 0;
+        return counts_[Offset(from, to) + (std::size_t)(dt + window_)];
+    }
+
+    std::uint64_t Entries(int from, int to) const
+    {
+        std::uint64_t n = 0;
+        for (long long dt = -window_; dt <= window_; ++dt) n += Count(from, to, dt);
+        return n;
+    }
+
+    double Mean(int from, int to) const
+    {
+        double n = 0.0, s = 0.0;
+        for (long long dt = -window_; dt <= window_; ++dt) {
+            double c = (double)Count(from, to, dt);
+            n += c;
+            s += c * (double)dt;
+        }
+        return (n > 0.0) ? s / n : 0.0;
+    }
+
+    double StdDev(int from, int to) const
+    {
+        const double m = Mean(from, to);
+        double n = 0.0, s = 0.0;
+        for (long long dt = -window_; dt <= window_; ++dt) {
+            double c = (double)Count(from, to, dt);
+            n += c;
+            s += c * ((double)dt - m) * ((double)dt - m);
+        }
+        return (n > 0.0) ? std::sqrt(s / n) : 0.0;
+    }
+
+    // dt più frequente (il più vicino a 0 a parità di conteggi)
+    long long Peak(int from, int to) const
+    {
+        long long best = 0;
+        std::uint64_t bestCount = 0;
+        for (long long dt = -window_; dt <= window_; ++dt) {
+            std::uint64_t c = Count(from, to, dt);
+            if (c > bestCount || (c == bestCount && c > 0 && std::llabs(dt) < std::llabs(best))) {
+                best      = dt;
+                bestCount = c;
+            }
+        }
+        return best;
+    }
+
+    // Distribuzione come istogramma, un bin per tick
+    FixedHistogram Histogram(int from, int to) const
+    {
+        FixedHistogram h(2 * (int)window_ + 1, -(double)window_ - 0.5, (double)window_ + 0.5);
+        for (long long dt = -window_; dt <= window_; ++dt) {
+            std::uint64_t c = Count(from, to, dt);
+            if (c > 0) h.Fill((double)dt, c);
+        }
+        return h;
+    }
+
+private:
+    std::size_t Offset(int from, int to) const
+    {
+        return (std::size_t)(from * SKEW_CHANNELS + to) * (std::size_t)(2 * window_ + 1);
+    }
+
+    long long                  window_;
+    std::vector<std::uint64_t> counts_;
+};
+
+template <class Layout = Mu5Layout>
+class BasicSkewAnalyzer {
+public:
+    explicit BasicSkewAnalyzer(long long windowTicks = SKEW_WINDOW_TICKS)
+        : matrix_(windowTicks) {}
+
+    // Eventi successivi (anche a blocchi, lo stato resta tra le chiamate)
+    void Process(const EventStore& ev)
+    {
+        const long long w = matrix_.Window();
+        for (std::size_t k = 0; k < ev.size(); ++k) {
+            const unsigned int bits = ChannelBits(ev.ch[k]);
+            if (bits == 0u) continue;
+            const long long t = ev.ticks[k];
+
+            while (!recent_.empty() && recent_.front().ticks < t - w) recent_.pop_front();
+
+            // bit diversi nella stessa riga: dt = 0
+            ForEachBit(bits, [&](int i) {
+                ForEachBit(bits, [&](int j) {
+                    if (i != j) matrix_.Fill(i, j, 0);
+                });
+            });
+
+            for (const Hit& p : recent_) {
+                const long long dt = t - p.ticks;
+                ForEachBit(p.bits, [&](int i) {
+                    ForEachBit(bits, [&](int j) {
+                        matrix_.Fill(i, j, dt);
+                        matrix_.Fill(j, i, -dt);
+                    });
+                });
+            }
+            recent_.push_back(Hit{t, bits});
+        }
+    }
+
+    const SkewMatrix& Matrix() const { return matrix_; }
+
+private:
+    struct Hit {
+        long long    ticks;
+        unsigned int bits;   // bit 0 … SKEW_CHANNELS-1
+    };
+
+    // Channel word → bit 0 START, 1 STOP, 2 … 5 PMT8 … PMT11
+    static unsigned int ChannelBits(unsigned int ch)
+    {
+        return ((ch & Layout::START) ? 1u : 0u) | ((ch & Layout::STOP) ? 2u : 0u) |
+               Layout::CanonicalBlocks(ch & Layout::BLOCK_MASK);
+    }
+
+    template <class Fn>
+    static void ForEachBit(unsigned int bits, Fn&& fn)
+    {
+        for (; bits != 0u; bits &= bits - 1u) fn(detail::CountTrailingZeros64(bits));
+    }
+
+    SkewMatrix      matrix_;
+    std::deque<Hit> recent_;
+};
+
+using SkewAnalyzer = BasicSkewAnalyzer<Mu5Layout>;
+
+// Matrice dei ritardi di un file (testo o binario, vedi FifoStream),
+// letto a blocchi. rows, se non nullo, riceve il numero di righe lette.
+// Ritorna false se il file non può essere aperto.
+inline bool ChannelSkewFile(const char* path, SkewMatrix& out,
+                            long long windowTicks = SKEW_WINDOW_TICKS,
+                            std::size_t* rows = nullptr,
+                            std::size_t chunkRows = (std::size_t)1 << 16)
+{
+    FifoStream in;
+    if (!in.Open(path)) return false;
+
+    FifoDecoder  decoder;
+    SkewAnalyzer skew(windowTicks);
+
+    std::vector<unsigned int> CH, CT;
+    EventStore                events;
+    events.reserve(chunkRows);
+
+    while (in.Next(CH, CT, chunkRows) > 0) {
+        events.clear();
+        decoder.Decode(CH.data(), CT.data(), CH.size(), events);
+        skew.Process(events);
+    }
+
+    out = skew.Matrix();
+    if (rows != nullptr) *rows = decoder.Rows();
+    return true;
+}
+
+// Tabelle della matrice: coppie, dt di picco e dt medio ± rms [tick],
+// riga = from, colonna = to (dt = t(to) - t(from))
+inline void WriteSkewMatrix(std::ostream& os, const SkewMatrix& m)
+{
+    char cell[48];
+    auto header = [&](const char* title) {
+        os << title << "\n  " << "from \\ to";
+        for (int j = 0; j < SKEW_CHANNELS; ++j) {
+            std::snprintf(cell, sizeof(cell), " %14s", SkewChannelName(j));
+            os << cell;
+        }
+        os << "\n";
+    };
+    auto table = [&](const char* title, auto&& value) {
+        header(title);
+        for (int i = 0; i < SKEW_CHANNELS; ++i) {
+            std::snprintf(cell, sizeof(cell), "  %9s", SkewChannelName(i));
+            os << cell;
+            for (int j = 0; j < SKEW_CHANNELS; ++j) {
+                if (m.Entries(i, j) == 0) {
+                    std::snprintf(cell, sizeof(cell), " %14s", "-");
+                } else {
+                    value(i, j);
+                }
+                os << cell;
+            }
+            os << "\n";
+        }
+    };
+
+    os << "Finestra: ±" << m.Window() << " tick\n";
+    table("Coppie", [&](int i, int j) {
+        std::snprintf(cell, sizeof(cell), " %14llu", (unsigned long long)m.Entries(i, j));
+    });
+    table("dt di picco [tick]", [&](int i, int j) {
+        std::snprintf(cell, sizeof(cell), " %14lld", m.Peak(i, j));
+    });
+    table("dt medio ± rms [tick]", [&](int i, int j) {
+        std::snprintf(cell, sizeof(cell), " %6.2f ± %5.2f", m.Mean(i, j), m.StdDev(i, j));
+    });
+}
+
+} // namespace mulife
+
+#endif // MULIFE_CHANNELSKEW_H
@@ -0,0 +1,371 @@
+#ifndef MULIFE_CLOCKCALIBRATION_H
+#define MULIFE_CLOCKCALIBRATION_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ostream>
+#include <vector>
+
+#include "FifoBinary.h"
+#include "Histogram.h"
+#include "MuDecoding.h"
+
+// =====================================================================
+//          CALIBRAZIONE DEL CLOCK E RITARDO TRA CANALI (senza ROOT)
+// =====================================================================
+//
+// Stessa analisi di Calibration e Delay in DEONANO.cpp, su FixedHistogram
+// invece che su TH1F, così può girare anche nell'eseguibile compilato.
+//
+// Calibrazione: con un'onda quadra di periodo noto T_s sul canale 1, la
+// differenza di counter tra due fronti consecutivi (CH == 1 seguito da
+// CH == 1) è il periodo in tick. La costante di calibrazione è
+//   a = T_s / <T>          [s/tick]
+// con errore dato dall'errore sulla media, a * (rms/sqrt(N)) / <T>.
+//
+// ClockCalibrator legge le righe a blocchi, in un solo passaggio e con
+// memoria costante, quindi anche prese di calibrazione molto lunghe:
+//   - media e rms del periodo sono calcolate con l'algoritmo di Welford
+//     (nessun binning, nessuna somma di quadrati ~1e16 da sottrarre);
+//     come nell'istogramma di Calibration contano solo i periodi in
+//     [periodMin, periodMax), gli altri (fronti persi, rumore) sono
+//     contati a parte;
+//   - ogni windowPeriods periodi accettati si chiude una finestra con la
+//     sua costante a: la serie delle finestre mostra la deriva del clock
+//     nel tempo, riassunta da una pendenza in ppm/ora;
+//   - l'istogramma del periodo resta, solo per il disegno.
+//
+// Il risultato può essere scritto in un file di calibrazione (testo,
+// "chiave = valore") che Mu_life_new e DecayTime leggono al posto dei
+// valori fissi tick_us e DECAYTIME_TICK_US.
+//
+// Ritardo: differenza di counter tra un evento sul canale 2 e l'evento
+// sul canale 1 che lo segue.
+// =====================================================================
+
+namespace mulife {
+
+const double CALIB_SIGNAL_PERIOD_S  = 0.932;                  // periodo del segnale misurato in laboratorio [s]
+const char*  const CLOCK_CALIBRATION_FILE = "ClockCalibration.txt";   // file di calibrazione di default
+
+// Media e varianza in un passaggio (Welford). La varianza è quella della
+// popolazione (divisa per N), come TH1::GetRMS.
+struct RunningStats {
+    std::uint64_t n    = 0;
+    double        mean = 0.0;
+    double        m2   = 0.0;   // somma dei quadrati degli scarti dalla media
+
+    void Add(double x)
+    {
+        ++n;
+        double d = x - mean;
+        mean += d / (double)n;
+        m2   += d * (x - mean);
+    }
+
+    // Unione di due campioni (Chan et al.)
+    void Merge(const RunningStats& o)
+    {
+        if (o.n == 0) return;
+        if (n == 0) {
+            *this = o;
+            return;
+        }
+        double nt = (double)(n + o.n);
+        double d  = o.mean - mean;
+        mean += d * (double)o.n / nt;
+        m2   += o.m2 + d * d * (double)n * (double)o.n / nt;
+        n    += o.n;
+    }
+
+    double Variance() const { return (n > 0) ? m2 / (double)n : 0.0; }
+    double StdDev()   const { return std::sqrt(Variance()); }
+    double MeanErr()  const { return (n > 0) ? StdDev() / std::sqrt((double)n) : 0.0; }
+};
+
+struct CalibrationConfig {
+    double        signalPeriodS = CALIB_SIGNAL_PERIOD_S;
+    double        periodMin     = 1.86e8;    // periodi accettati [tick], come
+    double        periodMax     = 1.875e8;   // l'istogramma di Calibration
+    std::uint64_t windowPeriods = 32;        // periodi per finestra di deriva
+};
+
+// Costante di calibrazione su una finestra di periodi consecutivi
+struct DriftWindow {
+    long long    firstTick = 0;   // primo fronte della finestra [tick dal primo fronte]
+    RunningStats period;          // periodi della finestra [tick]
+    double       a    = 0.0;      // [s/tick]
+    double       aErr = 0.0;
+};
+
+struct ClockCalibration {
+    FixedHistogram period{100, 1.86e8, 1.875e8};   // periodo [tick], come in Calibration
+    RunningStats   stats;                          // periodi accettati [tick]
+    std::uint64_t  rejected   = 0;                 // periodi fuori da [periodMin, periodMax)
+    std::uint64_t  rows       = 0;                 // righe lette
+    double         periodMean = 0.0;
+    double         periodRms  = 0.0;
+    double         periodErr  = 0.0;                // rms / sqrt(N)
+    double         a          = 0.0;                // [s/tick]
+    double         aErr       = 0.0;
+
+    std::vector<DriftWindow> drift;
+    double         driftPpmPerHour    = 0.0;        // pendenza di a nel tempo, relativa ad a
+    double         driftPpmPerHourErr = 0.0;
+
+    double TickUs()    const { return a * 1e6; }
+    double TickUsErr() const { return aErr * 1e6; }
+};
+
+namespace detail {
+
+// Costante di calibrazione ed errore da media ed errore del periodo
+inline void CalibrationFromPeriod(double signalPeriodS, double mean, double meanErr,
+                                  double& a, double& aErr)
+{
+    a    = (mean > 0.0) ? signalPeriodS / mean : 0.0;
+    aErr = (mean > 0.0) ? a * (meanErr / mean) : 0.0;
+}
+
+} // namespace detail
+
+class ClockCalibrator {
+public:
+    explicit ClockCalibrator(const CalibrationConfig& config = CalibrationConfig())
+        : config_(config) {}
+
+    // Righe successive della presa di calibrazione (anche a blocchi)
+    void Feed(const unsigned int* CH, const unsigned int* CT, std::size_t n)
+    {
+        for (std::size_t k = 0; k < n; ++k) {
+            const unsigned int ch = CH[k];
+
+            if (Mu5Layout::IsReset(ch)) {
+                ++nReset_;
+                prevEdge_ = false;
+                continue;
+            }
+            if (ch != 1u) {
+                prevEdge_ = false;
+                continue;
+            }
+
+            const long long ticks = (nReset_ << COUNTER_BITS) | (long long)(CT[k] & COUNTER_MASK);
+            if (!seenEdge_) {
+                seenEdge_  = true;
+                firstTick_ = ticks;
+            }
+
+            if (prevEdge_) {
+                const double T = (double)CT[k] - (double)prevCT_;
+                res_.period.Fill(T);
+                if (T >= config_.periodMin && T < config_.periodMax) {
+                    if (window_.n == 0) windowFirst_ = prevTicks_ - firstTick_;
+                    res_.stats.Add(T);
+                    window_.Add(T);
+                    if (window_.n >= config_.windowPeriods) CloseWindow();
+                } else {
+                    ++res_.rejected;
+                }
+            }
+            prevEdge_  = true;
+            prevCT_    = CT[k];
+            prevTicks_ = ticks;
+        }
+        res_.rows += n;
+    }
+
+    // Risultato con le righe viste finora; false se nessun periodo è
+    // stato accettato
+    bool Result(ClockCalibration& res) const
+    {
+        res = res_;
+        ClockCalibrator tmp(*this);
+        if (tmp.window_.n >= 2) tmp.CloseWindow();   // ultima finestra, se non troppo corta
+        res.drift = tmp.res_.drift;
+
+        if (res.stats.n == 0) return false;
+        res.periodMean = res.stats.mean;
+        res.periodRms  = res.stats.StdDev();
+        res.periodErr  = res.stats.MeanErr();
+        detail::CalibrationFromPeriod(config_.signalPeriodS, res.periodMean, res.periodErr,
+                                      res.a, res.aErr);
+        FitDrift(res);
+        return res.a > 0.0;
+    }
+
+private:
+    void CloseWindow()
+    {
+        DriftWindow w;
+        w.firstTick = windowFirst_;
+        w.period    = window_;
+        detail::CalibrationFromPeriod(config_.signalPeriodS, w.period.mean, w.period.MeanErr(),
+                                      w.a, w.aErr);
+        res_.drift.push_back(w);
+        window_ = RunningStats();
+    }
+
+    // Retta a(t) = a0 + s*t sulle finestre (minimi quadrati pesati con
+    // 1/aErr^2), con t al centro della finestra; pendenza in ppm/ora di a
+    static void FitDrift(ClockCalibration& res)
+    {
+        double sw = 0.0, swt = 0.0, swa = 0.0, swtt = 0.0, swta = 0.0;
+        for (const DriftWindow& w : res.drift) {
+            if (w.aErr <= 0.0) continue;
+            double t  = ((double)w.firstTick + 0.5 * w.period.mean * (double)w.period.n) * res.a / 3600.0;   // [h]
+            double wt = 1.0 / (w.aErr * w.aErr);
+            sw   += wt;
+            swt  += wt * t;
+            swa  += wt * w.a;
+            swtt += wt * t * t;
+            swta += wt * t * w.a;
+        }
+        double det = sw * swtt - swt * swt;
+        if (sw <= 0.0 || !(det > 0.0)) return;
+        double slope    = (sw * swta - swt * swa) / det;   // [s/tick per ora]
+        double slopeErr = std::sqrt(sw / det);
+        res.driftPpmPerHour    = slope / res.a * 1e6;
+        res.driftPpmPerHourErr = slopeErr / res.a * 1e6;
+    }
+
+    CalibrationConfig config_;
+    ClockCalibration  res_;
+    RunningStats      window_;
+    long long         windowFirst_ = 0;
+
+    long long    nReset_    = 0;
+    bool         seenEdge_  = false;
+    long long    firstTick_ = 0;
+    bool         prevEdge_  = false;   // la riga precedente è un fronte (CH == 1)
+    unsigned int prevCT_    = 0;
+    long long    prevTicks_ = 0;
+};
+
+// Ritorna false se nessun periodo cade nell'intervallo accettato
+inline bool CalibrateClock(const std::vector<unsigned int>& CH,
+                           const std::vector<unsigned int>& CT,
+                           ClockCalibration& res,
+                           double signalPeriodS = CALIB_SIGNAL_PERIOD_S)
+{
+    CalibrationConfig config;
+    config.signalPeriodS = signalPeriodS;
+    ClockCalibrator cal(config);
+    cal.Feed(CH.data(), CT.data(), (CH.size() < CT.size()) ? CH.size() : CT.size());
+    return cal.Result(res);
+}
+
+// Calibrazione direttamente da file (testo o binario, vedi FifoStream),
+// a blocchi. Ritorna false se il file non può essere aperto o se nessun
+// periodo è stato accettato (res.rows dice quale dei due).
+inline bool CalibrateClockFile(const char* path, ClockCalibration& res,
+                               const CalibrationConfig& config = CalibrationConfig(),
+                               std::size_t chunkRows = (std::size_t)1 << 16)
+{
+    res = ClockCalibration();
+    FifoStream in;
+    if (!in.Open(path)) return false;
+
+    ClockCalibrator cal(config);
+    std::vector<unsigned int> CH, CT;
+    while (in.Next(CH, CT, chunkRows) > 0) cal.Feed(CH.data(), CT.data(), CH.size());
+    return cal.Result(res);
+}
+
+// Tabella delle finestre di deriva
+inline void WriteDriftTable(std::ostream& os, const ClockCalibration& cal)
+{
+    char line[160];
+    os << "  finestra    t [s]   periodi    <T> [tick]     a [µs/tick]       ±\n";
+    for (std::size_t i = 0; i < cal.drift.size(); ++i) {
+        const DriftWindow& w = cal.drift[i];
+        std::snprintf(line, sizeof(line), "  %8zu %8.1f %9llu %13.1f %15.8e %11.2e\n",
+                      i, (double)w.firstTick * cal.a, (unsigned long long)w.period.n,
+                      w.period.mean, w.a * 1e6, w.aErr * 1e6);
+        os << line;
+    }
+    std::snprintf(line, sizeof(line), "  deriva: %.3f ± %.3f ppm/ora\n",
+                  cal.driftPpmPerHour, cal.driftPpmPerHourErr);
+    os << line;
+}
+
+// =====================================================================
+//                        FILE DI CALIBRAZIONE
+// =====================================================================
+//
+// Righe "chiave = valore", '#' per i commenti. La chiave usata dalle
+// analisi è tick_us; le altre sono per chi legge il file.
+
+inline bool SaveClockCalibration(const char* path, const ClockCalibration& cal,
+                                 const char* source = "",
+                                 double signalPeriodS = CALIB_SIGNAL_PERIOD_S)
+{
+    std::FILE* f = std::fopen(path, "w");
+    if (f == nullptr) return false;
+    std::fprintf(f, "# Calibrazione del clock (ClockCalibration.h)\n");
+    std::fprintf(f, "source             = %s\n", source);
+    std::fprintf(f, "tick_us            = %.10g\n", cal.TickUs());
+    std::fprintf(f, "tick_us_err        = %.6g\n", cal.TickUsErr());
+    std::fprintf(f, "signal_period_s    = %.10g\n", signalPeriodS);
+    std::fprintf(f, "period_ticks       = %.10g\n", cal.periodMean);
+    std::fprintf(f, "period_rms_ticks   = %.6g\n", cal.periodRms);
+    std::fprintf(f, "periods            = %llu\n", (unsigned long long)cal.stats.n);
+    std::fprintf(f, "rejected           = %llu\n", (unsigned long long)cal.rejected);
+    std::fprintf(f, "windows            = %zu\n", cal.drift.size());
+    std::fprintf(f, "drift_ppm_per_hour = %.6g\n", cal.driftPpmPerHour);
+    std::fprintf(f, "drift_ppm_per_hour_err = %.6g\n", cal.driftPpmPerHourErr);
+    return std::fclose(f) == 0;
+}
+
+// Legge tick_us [µs] (e, se presente, tick_us_err) da un file di
+// calibrazione. Ritorna false se il file non c'è o non ha un tick_us > 0.
+inline bool LoadTickUs(const char* path, double& tickUs, double* tickUsErr = nullptr)
+{
+    std::FILE* f = std::fopen(path, "r");
+    if (f == nullptr) return false;
+
+    double tick = 0.0, err = 0.0;
+    char line[512];
+    while (std::fgets(line, sizeof(line), f) != nullptr) {
+        char* eq = std::strchr(line, '=');
+        if (line[0] == '#' || eq == nullptr) continue;
+        char* key = line;
+        while (*key == ' ' || *key == '\t') ++key;
+        std::size_t len = (std::size_t)(eq - key);
+        while (len > 0 && (key[len - 1] == ' ' || key[len - 1] == '\t')) --len;
+
+        if (len == 7 && std::strncmp(key, "tick_us", 7) == 0) {
+            tick = std::strtod(eq + 1, nullptr);
+        } else if (len == 11 && std::strncmp(key, "tick_us_err", 11) == 0) {
+            err = std::strtod(eq + 1, nullptr);
+        }
+    }
+    std::fclose(f);
+
+    if (!(tick > 0.0)) return false;
+    tickUs = tick;
+    if (tickUsErr != nullptr) *tickUsErr = err;
+    return true;
+}
+
+// Istogramma del ritardo canale 2 → canale 1 [tick], come in Delay
+inline FixedHistogram ChannelDelay(const std::vector<unsigned int>& CH,
+                                   const std::vector<unsigned int>& CT)
+{
+    FixedHistogram h(10, -2.0, 2.0);
+    const std::size_t n = (CH.size() < CT.size()) ? CH.size() : CT.size();
+    for (std::size_t i = 0; i + 1 < n; ++i) {
+        if (CH[i] == 2u && CH[i + 1] == 1u) {
+            h.Fill((double)CT[i] - (double)CT[i + 1]);
+        }
+    }
+    return h;
+}
+
+} // namespace mulife
+
+#endif // MULIFE_CLOCKCALIBRATION_H
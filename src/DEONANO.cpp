@@ -1,6 +1,15 @@
 #include <iostream>
 #include <fstream>
 #include <vector>
+#include <cmath>
+#include <string>
+#include "TH1F.h"
+#include "TCanvas.h"
+
+#include "FifoBinary.h"
+#include "ChannelSkew.h"
+#include "ClockCalibration.h"
+#include "RootSink.h"
 using namespace std;
 
 
@@ -11,43 +20,30 @@ using namespace std;
 *(2) Loops over CLKv, and calculates difference between two following clock fronts. It is saved inside an histogram.
 *(3) The histogram is then plotted. The user can then make usage of various root utilities on it.
 *(4) The calibration constant is estimated with reference period of the original signal measured in the Lab.
+*The file is read in blocks in a single pass (see ClockCalibration.h): mean and rms of the period come from a running (Welford)
+*accumulator, the histogram is only for drawing. The constant is also computed on windows of windowPeriods periods, to see
+*the drift of the clock, and saved in calibFile, which Mu_life_new and DecayTime then use instead of their fixed values.
 */
 
-void Calibration(const char* path) {
+void Calibration(const char* path, const char* calibFile = "ClockCalibration.txt", int windowPeriods = 32) {
 
-    ifstream FIFO(path);
+    mulife::CalibrationConfig config;
 
-    vector<double> CHv, CLKv;
+    config.windowPeriods = (windowPeriods > 1) ? windowPeriods : 2;
 
-    double CH , CLK;
+    mulife::ClockCalibration cal;
 
-    TH1F *Period = new TH1F("Period", "Histogram of period of calibration signal", 100 , 1.86e8 ,1.875e8 );
+    if (!mulife::CalibrateClockFile(path, cal, config)) {
 
-    while (FIFO >> CH >> CLK){
+        if (cal.rows == 0) cerr << "Cannot open " << path << endl;
 
-        CHv.push_back(CH);
+        else cerr << "No period of the calibration signal found in " << path << endl;
 
-        CLKv.push_back(CLK);
+        return;
 
     }
 
-    int lenCH = CHv.size();
-
-    int lenCLK = CLKv.size();
-
-    for (int i = 0; i < (lenCH-1) ; i++){
-
-        if (CHv[i] == 1 && CHv[i+1] == 1){
-
-            double T = CLKv[i+1] - CLKv[i];
-
-            Period->Fill(T);
-
-        }
-        else{
-            continue;
-        }
-    }
+    TH1F *Period = mulife::MakeTH1F(cal.period, "Period", "Histogram of period of calibration signal");
 
     TCanvas* c = new TCanvas("Period", "Canvas Period of calibration signal", 800, 600);
 
@@ -57,21 +53,17 @@ void Calibration(const char* path) {
 
     Period->Draw();
 
-    double T_mean = Period->GetMean();
-
-    double T_std = Period->GetRMS();
-
-    double Entries = Period->GetEntries();
+    cout << cal.a << "+/-" << cal.aErr <<endl;
 
-    double T_err = T_std/sqrt(Entries);
+    mulife::WriteDriftTable(cout, cal);
 
-    double T_s = 0.932;
+    if (calibFile != nullptr && calibFile[0] != '\0') {
 
-    double a = T_s/T_mean;
+        if (mulife::SaveClockCalibration(calibFile, cal, path, config.signalPeriodS)) cout << "Calibration saved in " << calibFile << endl;
 
-    double a_err = a * (T_err/T_mean);
+        else cerr << "Cannot write " << calibFile << endl;
 
-    cout << a << "+/-" << a_err <<endl;
+    }
 
 }
 
@@ -86,45 +78,77 @@ void Calibration(const char* path) {
 
 void Delay(const char* path) {
 
-    ifstream FIFO(path);
+    vector<unsigned int> CHv, CLKv;
 
-    vector<double> CHv, CLKv;
+    if (!mulife::LoadFifo(path, CHv, CLKv)) {
 
-    double CH , CLK;
+        cerr << "Cannot open " << path << endl;
 
-    TH1F *delay = new TH1F("Delay between 0 and 1", "Histogram of delay between channel", 10 , -2, 2);
+        return;
 
-    while (FIFO >> CH >> CLK){
+    }
 
-        CHv.push_back(CH);
+    // CH == 2 followed by CH == 1, without reading past the last row (see ChannelDelay)
+    TH1F *delay = mulife::MakeTH1F(mulife::ChannelDelay(CHv, CLKv), "Delay between 0 and 1", "Histogram of delay between channel");
 
-        CLKv.push_back(CLK);
+    TCanvas* c = new TCanvas("Delay 1-0", "Canvas Delay Time between 1-0", 800, 600);
 
-    }
+    delay->GetXaxis()->SetTitle("Delay Time [a.u.]");
 
-    int lenCH = CHv.size();
+    delay->GetYaxis()->SetTitle("Counts [pure]");
 
-    int lenCLK = CLKv.size();
+    delay->Draw();
+}
 
-    for(int i = 0; i < lenCH ; i++){
 
-        if (CHv[i] == 2 && CHv[i+1] == 1){
 
-            double dt = CLKv[i]-CLKv[i+1];
+/*
+*Meant to be used as root macro.
+*Generalisation of Delay: delay between every ordered pair of channel bits (START, STOP, PMT8-11), see ChannelSkew.h.
+*(1) The file is read in blocks and decoded (absolute time in ticks, as in Mu_life5);
+*(2) every event is compared with all the events in the previous windowTicks ticks (not only the row before), and
+*t(to) - t(from) is counted for each pair of bits, 0 for two bits in the same row;
+*(3) the tables (pairs, peak and mean delay) are printed and the distribution of every pair with entries is drawn.
+*/
 
-            delay->Fill(dt);
+void Skew(const char* path, int windowTicks = 16) {
+
+    mulife::SkewMatrix m;
+
+    if (!mulife::ChannelSkewFile(path, m, windowTicks)) {
+
+        cerr << "Cannot open " << path << endl;
+
+        return;
 
-        }
     }
 
-    TCanvas* c = new TCanvas("Delay 1-0", "Canvas Delay Time between 1-0", 800, 600);
+    mulife::WriteSkewMatrix(cout, m);
 
-    delay->GetXaxis()->SetTitle("Delay Time [a.u.]");
+    TCanvas* c = new TCanvas("Skew", "Canvas delay between channel bits", 1200, 1200);
 
-    delay->GetYaxis()->SetTitle("Counts [pure]");
+    c->Divide(mulife::SKEW_CHANNELS, mulife::SKEW_CHANNELS);
 
-    delay->Draw();
-}
+    for (int i = 0; i < mulife::SKEW_CHANNELS; i++){
+
+        for (int j = 0; j < mulife::SKEW_CHANNELS; j++){
 
+            if (m.Entries(i, j) == 0) continue;
 
+            string name = string("Skew_") + mulife::SkewChannelName(i) + "_" + mulife::SkewChannelName(j);
 
+            string title = string("t(") + mulife::SkewChannelName(j) + ") - t(" + mulife::SkewChannelName(i) + ")";
+
+            TH1F* h = mulife::MakeTH1F(m.Histogram(i, j), name.c_str(), title.c_str());
+
+            h->GetXaxis()->SetTitle("Delay [ticks]");
+
+            c->cd(i * mulife::SKEW_CHANNELS + j + 1);
+
+            h->Draw();
+
+        }
+
+    }
+
+}
@@ -1,6 +1,10 @@
 #include <iostream>
-#include <fstream>
-#include <vector>
+#include "TH1F.h"
+#include "TF1.h"
+#include "TCanvas.h"
+
+#include "ClockCalibration.h"
+#include "DecayTimePairing.h"
 using namespace std;
 
 /*
@@ -10,71 +14,33 @@ using namespace std;
 *(1) Imports a file (specified by a path given as an input) assumed to have to columns, that will be converted in CHv (it corresponds to
 *the channel that was activated at a given time) and CLKv (the time in which the channel was triggered)
 *(2) Loops over CHv until it finds 1 (START signal): if so it increments index until it finds a 2(STOP signal), if the difference is more 
-*than 8 clock cycles, it is multiplied by a calibration constant (see Calibration) and registered in an histogram.
+*than 20 clock cycles, it is multiplied by a calibration constant (see Calibration) and registered in an histogram.
+*The constant is read from the calibration file written by Calibration, if there is one (4.98892e-3 us/tick otherwise).
+*The rows are read in blocks and paired in a single forward pass (see DecayTimePairing.h), without going through a TTree.
 *(3) The histogram is then plotted, the user can work with it with various root utilities
 */
 
-void DecayTime(const char* path) {
-    
-    ifstream FIFO(path);
-    
-    TTree* DecayTree = new TTree("Tree", "DecayTree");
-
-    long CH, CLK;
-
-    DecayTree->Branch("CH", &CH, "CH/I");
-    DecayTree->Branch("CLK", &CLK, "CLK/I");
+void DecayTime(const char* path, const char* calibFile = "ClockCalibration.txt") {
 
     TH1F *h = new TH1F("Results", "Decay time histogram", 100, 0, 20);
 
-    while (FIFO >> CH >> CLK){
-
-        if (CH > 2){continue;}
-
-        else {DecayTree->Fill();}
+    double a = mulife::DECAYTIME_TICK_US;
 
+    if (calibFile != nullptr && calibFile[0] != '\0' && mulife::LoadTickUs(calibFile, a)) {
+        cout << "Calibration constant from " << calibFile << ": " << a << " us/tick" << endl;
     }
 
-    Long64_t N = DecayTree->GetEntries();
-
-    double a = 4.98892e-3;
-
-    for (Long64_t i = 0 ; i < N ; i++){
-
-        DecayTree->GetEntry(i);
-
-        if (CH == 1) {
-
-            long START = CLK;
-
-            Long64_t j = i + 1;
-
-            while (j < N) {
+    size_t rows = 0;
 
-                DecayTree->GetEntry(j);
-
-                long STOP = CLK;
-
-                long diff = STOP-START;
-
-                if (CH == 2 && diff > 20){
-
-                    h->Fill(a * diff);
-
-                    break;
-
-                }
-
-                else {j++;}
-
-            }
-
-            i = j+1;
-
-        }
+    bool ok = mulife::StreamDecayTimes(path, [&](long long diff) { h->Fill(a * diff); }, &rows);
 
+    if (!ok) {
+        cerr << "Cannot open " << path << endl;
+        return;
     }
 
+    cout << rows << " rows, " << (long long)h->GetEntries() << " decays" << endl;
+
         TCanvas* c = new TCanvas("c_decay", "Canvas Decay Time", 800, 600);
 
     h->GetXaxis()->SetTitle("Decay Time [us]");
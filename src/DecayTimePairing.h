@@ -0,0 +1,120 @@
+#ifndef MULIFE_DECAYTIMEPAIRING_H
+#define MULIFE_DECAYTIMEPAIRING_H
+
+#include <cstddef>
+#include <vector>
+
+#include "FifoBinary.h"
+#include "MuDecoding.h"
+
+// =====================================================================
+//          PAIRING DI DECAYTIME (un passaggio, senza TTree)
+// =====================================================================
+//
+// Stessa logica di DecayTime in DecayTime.cpp (layout DecayTimeLayout:
+// CH == 1 START, CH == 2 STOP, righe con CH > 2 scartate, counter a
+// 32 bit senza reset):
+//
+//   - a ogni START si cerca in avanti il primo STOP con
+//     diff = CT(stop) - CT(start) > DECAYTIME_MIN_TICKS; gli START
+//     incontrati nel frattempo sono ignorati;
+//   - trovato lo STOP, si riparte saltando anche la riga (con CH <= 2)
+//     che lo segue, come faceva il ciclo originale (i = j + 1 e poi i++).
+//
+// Invece di riempire un TTree con tutte le righe e rileggerle con
+// GetEntry, le righe sono decodificate a blocchi in un EventStore
+// (array separati di tempo e channel word) e scorse una volta sola,
+// in avanti: O(N) e memoria costante. Lo stato (START in attesa, riga
+// da saltare) passa da un blocco al successivo.
+// =====================================================================
+
+namespace mulife {
+
+const double    DECAYTIME_TICK_US   = 4.98892e-3;   // a [µs/tick] senza file di calibrazione
+const long long DECAYTIME_MIN_TICKS = 20;           // diff minimo (escluso) START → STOP [tick]
+
+class DecayTimePairer {
+public:
+    explicit DecayTimePairer(long long minTicks = DECAYTIME_MIN_TICKS)
+        : minTicks_(minTicks) {}
+
+    // Accoda in out la differenza in tick di ogni coppia completata nel blocco
+    void Process(const EventStore& ev, std::vector<long long>& out)
+    {
+        const std::size_t  n     = ev.size();
+        const unsigned int* ch   = ev.ch.data();
+        const long long*   ticks = ev.ticks.data();
+
+        bool      waiting = waiting_;
+        bool      skip    = skip_;
+        long long tStart  = tStart_;
+
+        for (std::size_t i = 0; i < n; ++i) {
+            if (skip) {
+                skip = false;
+                continue;
+            }
+            if (!waiting) {
+                if (ch[i] == DecayTimeLayout::START) {
+                    waiting = true;
+                    tStart  = ticks[i];
+                }
+                continue;
+            }
+            const long long diff = ticks[i] - tStart;
+            if (ch[i] == DecayTimeLayout::STOP && diff > minTicks_) {
+                out.push_back(diff);
+                waiting = false;
+                skip    = true;
+            }
+        }
+
+        waiting_ = waiting;
+        skip_    = skip;
+        tStart_  = tStart;
+    }
+
+private:
+    long long minTicks_;
+    bool      waiting_ = false;   // START visto, STOP non ancora trovato
+    bool      skip_    = false;   // la prossima riga va saltata
+    long long tStart_  = 0;
+};
+
+// Lettura (testo o binario, vedi FifoStream), decodifica e pairing di
+// DecayTime a blocchi. sink(long long diffTicks) viene chiamato per ogni
+// coppia, in ordine. rows, se non nullo, riceve il numero di righe lette.
+// Ritorna false se il file non può essere aperto.
+template <class Sink>
+bool StreamDecayTimes(const char* path, Sink&& sink, std::size_t* rows = nullptr,
+                      long long minTicks = DECAYTIME_MIN_TICKS,
+                      std::size_t chunkRows = (std::size_t)1 << 16)
+{
+    FifoStream in;
+    if (!in.Open(path)) return false;
+
+    BasicFifoDecoder<DecayTimeLayout> decoder;
+    DecayTimePairer                   pairer(minTicks);
+
+    std::vector<unsigned int> CH;
+    std::vector<unsigned int> CT;
+    EventStore                events;
+    std::vector<long long>    diffs;
+    events.reserve(chunkRows);
+
+    while (in.Next(CH, CT, chunkRows) > 0) {
+        events.clear();
+        decoder.Decode(CH.data(), CT.data(), CH.size(), events);
+
+        diffs.clear();
+        pairer.Process(events, diffs);
+        for (long long d : diffs) sink(d);
+    }
+
+    if (rows != nullptr) *rows = decoder.Rows();
+    return true;
+}
+
+} // namespace mulife
+
+#endif // MULIFE_DECAYTIMEPAIRING_H
@@ -0,0 +1,207 @@
+#ifndef MULIFE_EVENTBITMAPS_H
+#define MULIFE_EVENTBITMAPS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "MuDecoding.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define MULIFE_AVX2_DISPATCH 1
+#include <immintrin.h>
+#endif
+
+// =====================================================================
+//            BITMAP DEI CANDIDATI START / STOP (pre-passaggio)
+// =====================================================================
+//
+// Prima del pairing l'array delle channel word di un blocco viene
+// trasformato in bitmap (1 bit per evento, parole da 64 bit):
+//
+//   start      : ch & START
+//   runEnd     : START seguito da un evento che non è START (ultimo di una
+//                serie: gli START precedenti vengono comunque sostituiti)
+//   earlyCand  : ch & (START | STOP_GENERIC)  → chiude l'attesa dello stop "immediato"
+//   finalCand  : ch & (START | STOP)          → chiude l'attesa dello stop finale
+//
+// I bit sono quelli del layout dei canali (Mu5Layout se non indicato,
+// vedi MuDecoding.h), costanti a compile time.
+//
+// La macchina a stati salta poi da un candidato al successivo con
+// NextSetBit (ctz sulla parola) invece di un test per evento.
+// Il pre-passaggio usa AVX2 (8 channel word per istruzione) se la CPU lo
+// supporta, scelto a runtime; altrimenti un ciclo scalare equivalente.
+// =====================================================================
+
+namespace mulife {
+
+struct EventBitmaps {
+    std::vector<std::uint64_t> start;
+    std::vector<std::uint64_t> runEnd;
+    std::vector<std::uint64_t> earlyCand;
+    std::vector<std::uint64_t> finalCand;
+    std::size_t                n = 0;             // numero di eventi (bit validi)
+    bool                       allEarly = false;  // tutti gli eventi sono in earlyCand
+
+    void resize(std::size_t nEvents)
+    {
+        n = nEvents;
+        std::size_t words = (nEvents + 63) / 64;
+        start.resize(words);
+        runEnd.resize(words);
+        earlyCand.resize(words);
+        finalCand.resize(words);
+    }
+};
+
+namespace detail {
+
+// Maschere delle tre bitmap per un layout dei canali
+template <class Layout>
+struct CandidateMasks {
+    static constexpr unsigned int START = Layout::START;
+    static constexpr unsigned int EARLY = Layout::START | Layout::STOP_GENERIC;
+    static constexpr unsigned int FINAL = Layout::START | Layout::STOP;
+};
+
+inline int CountTrailingZeros64(std::uint64_t w)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(w);
+#else
+    int k = 0;
+    while ((w & 1u) == 0u) { w >>= 1; ++k; }
+    return k;
+#endif
+}
+
+inline int PopCount64(std::uint64_t w)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(w);
+#else
+    int k = 0;
+    for (; w != 0u; w &= w - 1) ++k;
+    return k;
+#endif
+}
+
+// Bitmap degli eventi [from, to), con from multiplo di 64
+template <class Layout>
+inline void BuildBitmapsScalar(const unsigned int* ch, std::size_t from, std::size_t to,
+                               EventBitmaps& bm)
+{
+    for (std::size_t base = from; base < to; base += 64) {
+        std::size_t m = (to - base < 64) ? to - base : 64;
+        std::uint64_t s = 0, e = 0, f = 0;
+        for (std::size_t k = 0; k < m; ++k) {
+            unsigned int c = ch[base + k];
+            s |= (std::uint64_t)((c & CandidateMasks<Layout>::START) != 0u) << k;
+            e |= (std::uint64_t)((c & CandidateMasks<Layout>::EARLY) != 0u) << k;
+            f |= (std::uint64_t)((c & CandidateMasks<Layout>::FINAL) != 0u) << k;
+        }
+        bm.start[base / 64]     = s;
+        bm.earlyCand[base / 64] = e;
+        bm.finalCand[base / 64] = f;
+    }
+}
+
+#if defined(MULIFE_AVX2_DISPATCH)
+
+// 8 bit (uno per channel word) di (ch & mask) != 0
+__attribute__((target("avx2")))
+inline std::uint64_t NonZeroBits8(__m256i v, __m256i mask)
+{
+    __m256i zero = _mm256_cmpeq_epi32(_mm256_and_si256(v, mask), _mm256_setzero_si256());
+    return (std::uint64_t)(~(unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(zero)) & 0xFFu);
+}
+
+template <class Layout>
+__attribute__((target("avx2")))
+inline void BuildBitmapsAVX2(const unsigned int* ch, std::size_t n, EventBitmaps& bm)
+{
+    const __m256i mStart = _mm256_set1_epi32((int)CandidateMasks<Layout>::START);
+    const __m256i mEarly = _mm256_set1_epi32((int)CandidateMasks<Layout>::EARLY);
+    const __m256i mFinal = _mm256_set1_epi32((int)CandidateMasks<Layout>::FINAL);
+
+    const std::size_t full = n / 64;
+    for (std::size_t w = 0; w < full; ++w) {
+        const unsigned int* p = ch + 64 * w;
+        std::uint64_t s = 0, e = 0, f = 0;
+        for (int k = 0; k < 8; ++k) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 8 * k));
+            s |= NonZeroBits8(v, mStart) << (8 * k);
+            e |= NonZeroBits8(v, mEarly) << (8 * k);
+            f |= NonZeroBits8(v, mFinal) << (8 * k);
+        }
+        bm.start[w]     = s;
+        bm.earlyCand[w] = e;
+        bm.finalCand[w] = f;
+    }
+    BuildBitmapsScalar<Layout>(ch, 64 * full, n, bm);
+}
+
+inline bool CpuHasAVX2()
+{
+    static const bool ok = __builtin_cpu_supports("avx2");
+    return ok;
+}
+
+#endif // MULIFE_AVX2_DISPATCH
+
+} // namespace detail
+
+// Riempie bm per le n channel word ch; useSimd = false forza il ciclo scalare
+template <class Layout = Mu5Layout>
+inline void BuildEventBitmaps(const unsigned int* ch, std::size_t n, EventBitmaps& bm,
+                              bool useSimd = true)
+{
+    bm.resize(n);
+#if defined(MULIFE_AVX2_DISPATCH)
+    if (useSimd && detail::CpuHasAVX2()) {
+        detail::BuildBitmapsAVX2<Layout>(ch, n, bm);
+    } else {
+        detail::BuildBitmapsScalar<Layout>(ch, 0, n, bm);
+    }
+#else
+    (void)useSimd;
+    detail::BuildBitmapsScalar<Layout>(ch, 0, n, bm);
+#endif
+
+    // fine delle serie di START e copertura di earlyCand, parola per parola
+    const std::size_t words = bm.start.size();
+    std::uint64_t all = ~(std::uint64_t)0;
+    for (std::size_t w = 0; w < words; ++w) {
+        std::uint64_t next = (w + 1 < words) ? bm.start[w + 1] : 0u;
+        bm.runEnd[w] = bm.start[w] & ~((bm.start[w] >> 1) | (next << 63));
+        std::uint64_t valid = (w + 1 < words || n % 64 == 0) ? ~(std::uint64_t)0
+                                                             : ((std::uint64_t)1 << (n % 64)) - 1;
+        all &= bm.earlyCand[w] | ~valid;
+    }
+    bm.allEarly = (all == ~(std::uint64_t)0);
+}
+
+// Primo bit acceso in [from, n), oppure n se non ce ne sono
+inline std::size_t NextSetBit(const std::uint64_t* bits, std::size_t from, std::size_t n)
+{
+    if (from >= n) return n;
+    std::size_t w = from / 64;
+    std::uint64_t word = bits[w] & (~(std::uint64_t)0 << (from % 64));
+    const std::size_t words = (n + 63) / 64;
+    while (word == 0u) {
+        if (++w == words) return n;
+        word = bits[w];
+    }
+    std::size_t k = 64 * w + (std::size_t)detail::CountTrailingZeros64(word);
+    return (k < n) ? k : n;
+}
+
+inline bool TestBit(const std::uint64_t* bits, std::size_t k)
+{
+    return ((bits[k / 64] >> (k % 64)) & 1u) != 0u;
+}
+
+} // namespace mulife
+
+#endif // MULIFE_EVENTBITMAPS_H
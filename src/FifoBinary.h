@@ -0,0 +1,331 @@
+#ifndef MULIFE_FIFOBINARY_H
+#define MULIFE_FIFOBINARY_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "FifoReader.h"
+
+// =====================================================================
+//                    FORMATO BINARIO DEI FILE FIFO
+// =====================================================================
+//
+// Versione compatta dei file FIFOread_*.txt, da generare una volta sola
+// con ConvertFifoToBinary (o con la macro FifoConvert.cpp):
+//
+//   header (40 byte)
+//     char     magic[8]    = "MUFIFOB1"
+//     uint32   version     = 1
+//     uint32   recordSize  = 8
+//     double   tick_ns     tick del contatore (5 ns se non indicato)
+//     uint64   nRows       numero di righe CH CT
+//     uint64   nResets     numero di parole di reset (bit31 di CH)
+//   record (8 byte ciascuno, little endian come la macchina che scrive)
+//     uint32   ch
+//     uint32   ct
+//
+// LoadFifo sceglie da sola: se il file indicato è già binario lo legge
+// direttamente, se accanto al .txt esiste un .bin non più vecchio del
+// testo usa quello, altrimenti fa il parsing del testo.
+//
+// tick_ns non cambia la lettura (i record sono sempre in tick): è reso
+// da FifoStream::TickNs() e da FifoHeaderTickUs, e mulife lo usa come
+// tick quando non c'è un file di calibrazione del clock.
+// =====================================================================
+
+namespace mulife {
+
+struct FifoBinaryHeader {
+    char          magic[8];
+    std::uint32_t version;
+    std::uint32_t recordSize;
+    double        tick_ns;
+    std::uint64_t nRows;
+    std::uint64_t nResets;
+};
+
+struct FifoRecord {
+    std::uint32_t ch;
+    std::uint32_t ct;
+};
+
+static_assert(sizeof(FifoBinaryHeader) == 40, "header FIFO binario: layout inatteso");
+static_assert(sizeof(FifoRecord) == 8, "record FIFO binario: layout inatteso");
+
+const char          FIFO_BINARY_MAGIC[8]  = {'M', 'U', 'F', 'I', 'F', 'O', 'B', '1'};
+const std::uint32_t FIFO_BINARY_VERSION   = 1u;
+const double        FIFO_DEFAULT_TICK_NS  = 5.0;
+const std::uint32_t FIFO_RESET_FLAG       = (1u << 31);
+
+// "dir/FIFOread_Take8.txt" -> "dir/FIFOread_Take8.bin"
+inline std::string BinaryPathFor(const char* textPath)
+{
+    std::filesystem::path p(textPath);
+    p.replace_extension(".bin");
+    return p.string();
+}
+
+// Vero se accanto al file di testo c'è un .bin non più vecchio del testo
+inline bool FreshBinaryFor(const char* textPath, std::string& binPath)
+{
+    namespace fs = std::filesystem;
+    std::error_code ecBin, ecText;
+    binPath = BinaryPathFor(textPath);
+    if (binPath == textPath || !fs::exists(binPath, ecBin)) return false;
+    fs::file_time_type tBin  = fs::last_write_time(binPath, ecBin);
+    fs::file_time_type tText = fs::last_write_time(textPath, ecText);
+    return !ecBin && !ecText && tBin >= tText;
+}
+
+inline bool IsFifoBinary(const char* data, std::size_t size)
+{
+    return size >= sizeof(FifoBinaryHeader) &&
+           std::memcmp(data, FIFO_BINARY_MAGIC, sizeof(FIFO_BINARY_MAGIC)) == 0;
+}
+
+inline bool WriteFifoBinary(const char* path,
+                            const std::vector<unsigned int>& CH,
+                            const std::vector<unsigned int>& CT,
+                            double tick_ns = FIFO_DEFAULT_TICK_NS)
+{
+    if (CH.size() != CT.size()) return false;
+
+    FifoBinaryHeader hdr;
+    std::memcpy(hdr.magic, FIFO_BINARY_MAGIC, sizeof(hdr.magic));
+    hdr.version    = FIFO_BINARY_VERSION;
+    hdr.recordSize = sizeof(FifoRecord);
+    hdr.tick_ns    = tick_ns;
+    hdr.nRows      = CH.size();
+    hdr.nResets    = 0;
+    for (unsigned int ch : CH) {
+        if (ch & FIFO_RESET_FLAG) ++hdr.nResets;
+    }
+
+    std::FILE* f = std::fopen(path, "wb");
+    if (f == nullptr) return false;
+
+    bool ok = std::fwrite(&hdr, sizeof(hdr), 1, f) == 1;
+
+    // scrittura a blocchi per non duplicare in memoria l'intero file
+    const std::size_t BLOCK = 1u << 16;
+    std::vector<FifoRecord> buf;
+    buf.reserve(BLOCK);
+    for (std::size_t i = 0; ok && i < CH.size(); i += BLOCK) {
+        std::size_t n = std::min(BLOCK, CH.size() - i);
+        buf.resize(n);
+        for (std::size_t k = 0; k < n; ++k) {
+            buf[k].ch = CH[i + k];
+            buf[k].ct = CT[i + k];
+        }
+        ok = std::fwrite(buf.data(), sizeof(FifoRecord), n, f) == n;
+    }
+
+    ok = (std::fclose(f) == 0) && ok;
+    if (!ok) std::remove(path);
+    return ok;
+}
+
+// Legge un file binario già mappato. Ritorna false se l'header non è
+// valido o il file è troncato.
+inline bool DecodeFifoBinary(const char* data, std::size_t size,
+                             std::vector<unsigned int>& CH,
+                             std::vector<unsigned int>& CT,
+                             FifoBinaryHeader* header = nullptr)
+{
+    CH.clear();
+    CT.clear();
+
+    if (!IsFifoBinary(data, size)) return false;
+
+    FifoBinaryHeader hdr;
+    std::memcpy(&hdr, data, sizeof(hdr));
+    if (hdr.version != FIFO_BINARY_VERSION || hdr.recordSize != sizeof(FifoRecord)) return false;
+    if ((size - sizeof(hdr)) / sizeof(FifoRecord) < hdr.nRows) return false;
+
+    const char* rec = data + sizeof(hdr);
+    CH.resize(hdr.nRows);
+    CT.resize(hdr.nRows);
+    for (std::size_t i = 0; i < hdr.nRows; ++i) {
+        FifoRecord r;
+        std::memcpy(&r, rec + i * sizeof(FifoRecord), sizeof(r));
+        CH[i] = r.ch;
+        CT[i] = r.ct;
+    }
+
+    if (header != nullptr) *header = hdr;
+    return true;
+}
+
+inline bool ReadFifoBinary(const char* path,
+                           std::vector<unsigned int>& CH,
+                           std::vector<unsigned int>& CT,
+                           FifoBinaryHeader* header = nullptr)
+{
+    MappedFile file;
+    if (!file.Open(path)) return false;
+    return DecodeFifoBinary(file.Data(), file.Size(), CH, CT, header);
+}
+
+// Converte un file di testo nel formato binario. Se binPath è nullptr
+// il file viene scritto accanto al .txt (vedi BinaryPathFor).
+inline bool ConvertFifoToBinary(const char* textPath,
+                                const char* binPath = nullptr,
+                                double tick_ns = FIFO_DEFAULT_TICK_NS)
+{
+    std::vector<unsigned int> CH;
+    std::vector<unsigned int> CT;
+    if (!ReadFifo(textPath, CH, CT)) return false;
+
+    std::string out = (binPath != nullptr) ? std::string(binPath) : BinaryPathFor(textPath);
+    return WriteFifoBinary(out.c_str(), CH, CT, tick_ns);
+}
+
+// Punto di ingresso unico per le macro: binario se disponibile, testo altrimenti.
+inline bool LoadFifo(const char* path,
+                     std::vector<unsigned int>& CH,
+                     std::vector<unsigned int>& CT)
+{
+    MappedFile file;
+    if (!file.Open(path)) return false;
+
+    if (IsFifoBinary(file.Data(), file.Size())) {
+        return DecodeFifoBinary(file.Data(), file.Size(), CH, CT);
+    }
+
+    std::string bin;
+    if (FreshBinaryFor(path, bin) && ReadFifoBinary(bin.c_str(), CH, CT)) return true;
+
+    ParseFifoFile(file, CH, CT);
+    return true;
+}
+
+// Lettura a blocchi di un file FIFO (testo o binario, con la stessa
+// logica di scelta di LoadFifo): a ogni Next() vengono resi al più
+// maxRows record, così la memoria usata non dipende dalla lunghezza
+// della presa dati.
+class FifoStream {
+public:
+    bool Open(const char* path)
+    {
+        Close();
+        if (!file_.Open(path)) return false;
+
+        std::string bin;
+        if (!IsFifoBinary(file_.Data(), file_.Size()) && FreshBinaryFor(path, bin)) {
+            if (!file_.Open(bin.c_str()) || !IsFifoBinary(file_.Data(), file_.Size())) {
+                if (!file_.Open(path)) return false;
+            }
+        }
+
+        pos_ = file_.Data();
+        end_ = file_.Data() + file_.Size();
+
+        if (IsFifoBinary(file_.Data(), file_.Size())) {
+            FifoBinaryHeader hdr;
+            std::memcpy(&hdr, file_.Data(), sizeof(hdr));
+            if (hdr.version != FIFO_BINARY_VERSION || hdr.recordSize != sizeof(FifoRecord) ||
+                (file_.Size() - sizeof(hdr)) / sizeof(FifoRecord) < hdr.nRows) {
+                Close();
+                return false;
+            }
+            binary_ = true;
+            rowsLeft_ = hdr.nRows;
+            tickNs_ = (hdr.tick_ns > 0.0 && hdr.tick_ns < 1e9) ? hdr.tick_ns : FIFO_DEFAULT_TICK_NS;
+            pos_ += sizeof(hdr);
+        }
+        return true;
+    }
+
+    void Close()
+    {
+        file_.Close();
+        pos_ = end_ = nullptr;
+        binary_ = false;
+        rowsLeft_ = 0;
+        tickNs_ = FIFO_DEFAULT_TICK_NS;
+    }
+
+    bool IsBinary() const { return binary_; }
+
+    // Tick del contatore [ns]: dall'header se il file è binario,
+    // altrimenti quello nominale
+    double TickNs() const { return tickNs_; }
+
+    // Sostituisce il contenuto di CH e CT con i prossimi record.
+    // Ritorna il numero di righe lette (0 a fine file).
+    std::size_t Next(std::vector<unsigned int>& CH,
+                     std::vector<unsigned int>& CT,
+                     std::size_t maxRows)
+    {
+        CH.clear();
+        CT.clear();
+        if (pos_ == nullptr || pos_ == end_) return 0;
+
+        if (binary_) {
+            std::size_t n = (std::size_t)std::min<std::uint64_t>(rowsLeft_, maxRows);
+            CH.resize(n);
+            CT.resize(n);
+            for (std::size_t i = 0; i < n; ++i) {
+                FifoRecord r;
+                std::memcpy(&r, pos_ + i * sizeof(FifoRecord), sizeof(r));
+                CH[i] = r.ch;
+                CT[i] = r.ct;
+            }
+            pos_ += n * sizeof(FifoRecord);
+            rowsLeft_ -= n;
+            if (rowsLeft_ == 0) pos_ = end_;
+            return n;
+        }
+
+        pos_ = ParseFifoText(pos_, end_, CH, CT, maxRows);
+        // meno righe del richiesto: testo finito o token non numerico
+        if (CH.size() < maxRows) pos_ = end_;
+        return CH.size();
+    }
+
+private:
+    MappedFile    file_;
+    const char*   pos_      = nullptr;
+    const char*   end_      = nullptr;
+    bool          binary_   = false;
+    std::uint64_t rowsLeft_ = 0;
+    double        tickNs_   = FIFO_DEFAULT_TICK_NS;
+};
+
+// Tick [µs] scritto nell'header di un file binario (o del .bin
+// aggiornato accanto al testo). false per i file di testo, che non lo
+// riportano: tickUs resta invariato.
+inline bool FifoHeaderTickUs(const char* path, double& tickUs)
+{
+    FifoStream in;
+    if (!in.Open(path) || !in.IsBinary()) return false;
+    tickUs = in.TickNs() * 1e-3;
+    return true;
+}
+
+// Come sopra per più file: tick comune a tutti i file binari. false se
+// nessuno è binario o se i tick sono diversi (tickUs invariato).
+inline bool FifoHeaderTickUs(const std::vector<std::string>& paths, double& tickUs)
+{
+    bool   found = false;
+    double tick  = 0.0;
+    for (const std::string& p : paths) {
+        double t = 0.0;
+        if (!FifoHeaderTickUs(p.c_str(), t)) continue;
+        if (found && t != tick) return false;
+        tick  = t;
+        found = true;
+    }
+    if (found) tickUs = tick;
+    return found;
+}
+
+} // namespace mulife
+
+#endif // MULIFE_FIFOBINARY_H
@@ -0,0 +1,56 @@
+#include <iostream>
+#include <algorithm>
+#include <string>
+#include <filesystem>
+
+#include "FifoBinary.h"
+
+// =====================================================================
+//                          FIFO_CONVERT
+// =====================================================================
+//
+// Conversione una tantum dei file FIFOread_*.txt nel formato binario
+// descritto in FifoBinary.h. Il .bin viene scritto accanto al .txt e
+// da quel momento Mu_life_new, DecayTime e Calibration lo caricano
+// direttamente (finché non è più vecchio del file di testo).
+//
+// Uso da ROOT:
+//   .L FifoConvert.cpp
+//   FifoConvert("data/Take/FIFOread_Take8.txt");   // un file
+//   FifoConvert("data/Take");                      // tutti i FIFOread_*.txt
+// =====================================================================
+
+void FifoConvert(const char* path)
+{
+    namespace fs = std::filesystem;
+
+    std::error_code ec;
+    std::vector<std::string> inputs;
+
+    if (fs::is_directory(path, ec)) {
+        for (const auto& entry : fs::directory_iterator(path, ec)) {
+            const fs::path& p = entry.path();
+            std::string name = p.filename().string();
+            if (name.rfind("FIFOread_", 0) == 0 && p.extension() == ".txt") {
+                inputs.push_back(p.string());
+            }
+        }
+        std::sort(inputs.begin(), inputs.end());
+    } else {
+        inputs.push_back(path);
+    }
+
+    if (inputs.empty()) {
+        std::cerr << "[ERRORE] Nessun file FIFOread_*.txt in " << path << "\n";
+        return;
+    }
+
+    for (const std::string& in : inputs) {
+        std::string out = mulife::BinaryPathFor(in.c_str());
+        if (!mulife::ConvertFifoToBinary(in.c_str(), out.c_str())) {
+            std::cerr << "[ERRORE] Conversione fallita: " << in << "\n";
+            continue;
+        }
+        std::cout << "[INFO] " << in << " -> " << out << "\n";
+    }
+}
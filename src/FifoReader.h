@@ -0,0 +1,241 @@
+#ifndef MULIFE_FIFOREADER_H
+#define MULIFE_FIFOREADER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(_WIN32)
+#include <fstream>
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// =====================================================================
+//                    LETTORE FILE FIFO (CH CT)
+// =====================================================================
+//
+// I file FIFOread_*.txt contengono due colonne di interi decimali
+// (channel word e counter word) separate da spazi/a capo.
+// Invece di passare per operator>> di un ifstream (stato di stream,
+// locale, controlli per ogni carattere) il file viene mappato in memoria
+// e le due colonne sono lette con uno scanner di interi scritto a mano,
+// direttamente nei vettori CH e CT.
+//
+// Sui blocchi da 16 byte lo scanner usa SSE2 per trovare in un colpo
+// solo la lunghezza della sequenza di cifre; vicino alla fine del buffer
+// si passa al ciclo scalare (niente letture oltre la mappatura).
+//
+// Come con "fin >> ch >> ct", la lettura si ferma al primo token che non
+// è un intero e un'eventuale colonna spaiata in fondo viene ignorata.
+// =====================================================================
+
+namespace mulife {
+
+// Mappatura in sola lettura di un file intero (RAII)
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { Close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const char* path)
+    {
+        Close();
+#if defined(_WIN32)
+        std::ifstream fin(path, std::ios::binary);
+        if (!fin.is_open()) return false;
+        fallback_.assign(std::istreambuf_iterator<char>(fin),
+                         std::istreambuf_iterator<char>());
+        data_ = fallback_.data();
+        size_ = fallback_.size();
+        return true;
+#else
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) return false;
+
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            return false;
+        }
+        size_ = (std::size_t)st.st_size;
+
+        if (size_ > 0) {
+            void* p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                ::close(fd);
+                size_ = 0;
+                return false;
+            }
+            ::madvise(p, size_, MADV_SEQUENTIAL);
+            data_ = static_cast<const char*>(p);
+        }
+        ::close(fd);
+        return true;
+#endif
+    }
+
+    void Close()
+    {
+#if defined(_WIN32)
+        fallback_.clear();
+#else
+        if (data_ != nullptr) ::munmap(const_cast<char*>(data_), size_);
+#endif
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    const char* Data() const { return data_; }
+    std::size_t Size() const { return size_; }
+
+private:
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+#if defined(_WIN32)
+    std::vector<char> fallback_;
+#endif
+};
+
+namespace detail {
+
+inline bool IsSpace(char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+}
+
+inline bool IsDigit(char c)
+{
+    return (unsigned char)(c - '0') < 10u;
+}
+
+// Numero di cifre consecutive a partire da p (al più 16), via SSE2.
+// Richiede almeno 16 byte leggibili da p.
+inline int CountDigits16(const char* p)
+{
+#if defined(__SSE2__)
+    __m128i v  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i ge = _mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1));
+    __m128i le = _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1));
+    unsigned int digits = (unsigned int)_mm_movemask_epi8(_mm_and_si128(ge, le));
+    unsigned int nondigits = ~digits & 0xFFFFu;
+    return nondigits ? __builtin_ctz(nondigits) : 16;
+#else
+    int n = 0;
+    while (n < 16 && IsDigit(p[n])) ++n;
+    return n;
+#endif
+}
+
+// Legge un intero decimale senza segno a partire da p.
+// Ritorna il puntatore al primo carattere non cifra, oppure nullptr
+// se in p non c'è nessuna cifra.
+inline const char* ParseUInt(const char* p, const char* end, std::uint64_t& value)
+{
+    std::uint64_t v = 0;
+    const char* q = p;
+
+    if (end - p >= 16) {
+        int n = CountDigits16(p);
+        if (n == 0) return nullptr;
+        if (n < 16) {
+            for (int k = 0; k < n; ++k) v = v * 10u + (std::uint64_t)(p[k] - '0');
+            value = v;
+            return p + n;
+        }
+        // più di 16 cifre: prosegue col ciclo scalare
+    }
+
+    while (q < end && IsDigit(*q)) {
+        v = v * 10u + (std::uint64_t)(*q - '0');
+        ++q;
+    }
+    if (q == p) return nullptr;
+    value = v;
+    return q;
+}
+
+inline const char* SkipSpaces(const char* p, const char* end)
+{
+    while (p < end && IsSpace(*p)) ++p;
+    return p;
+}
+
+} // namespace detail
+
+// Analizza il testo [p, end) come coppie "CH CT" e le accoda in CH e CT,
+// al più maxRows righe. Ritorna il puntatore al punto in cui si è fermata
+// la lettura (end se il testo è finito).
+inline const char* ParseFifoText(const char* p, const char* end,
+                                 std::vector<unsigned int>& CH,
+                                 std::vector<unsigned int>& CT,
+                                 std::size_t maxRows = (std::size_t)-1)
+{
+    std::uint64_t ch = 0;
+    std::uint64_t ct = 0;
+
+    for (std::size_t n = 0; n < maxRows; ++n) {
+        const char* q = detail::SkipSpaces(p, end);
+        if (q == end) return q;
+
+        q = detail::ParseUInt(q, end, ch);
+        if (q == nullptr) return p;
+
+        q = detail::SkipSpaces(q, end);
+        q = detail::ParseUInt(q, end, ct);
+        if (q == nullptr) return p;
+
+        CH.push_back((unsigned int)ch);
+        CT.push_back((unsigned int)ct);
+        p = q;
+    }
+    return p;
+}
+
+// Analizza un file FIFO già mappato (CH e CT vengono svuotati).
+inline void ParseFifoFile(const MappedFile& file,
+                          std::vector<unsigned int>& CH,
+                          std::vector<unsigned int>& CT)
+{
+    CH.clear();
+    CT.clear();
+
+    // ~16 byte per riga nei file di presa dati
+    std::size_t estimate = file.Size() / 16 + 16;
+    CH.reserve(estimate);
+    CT.reserve(estimate);
+
+    ParseFifoText(file.Data(), file.Data() + file.Size(), CH, CT);
+}
+
+// Legge l'intero file FIFO nei vettori CH e CT (che vengono svuotati).
+// Ritorna false se il file non può essere aperto.
+inline bool ReadFifo(const char* path,
+                     std::vector<unsigned int>& CH,
+                     std::vector<unsigned int>& CT)
+{
+    CH.clear();
+    CT.clear();
+
+    MappedFile file;
+    if (!file.Open(path)) return false;
+
+    ParseFifoFile(file, CH, CT);
+    return true;
+}
+
+} // namespace mulife
+
+#endif // MULIFE_FIFOREADER_H
@@ -0,0 +1,204 @@
+#ifndef MULIFE_HISTOGRAM_H
+#define MULIFE_HISTOGRAM_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "MuDecoding.h"
+
+// =====================================================================
+//          ISTOGRAMMI A BINNING FISSO SENZA ROOT (anche multi-thread)
+// =====================================================================
+//
+// TH1F::Fill non si può chiamare da più thread sullo stesso oggetto.
+// FixedHistogram è l'equivalente minimo: stessi bin di un TH1F con
+// (nbins, xmin, xmax), compresi underflow (bin 0) e overflow (bin
+// nbins+1), conteggi interi e le somme che ROOT usa per media e RMS.
+//
+// Per riempirlo da più thread si usa ShardedHistogram: una copia per
+// thread (su linee di cache separate, nessuna operazione atomica nel
+// ciclo caldo), sommate alla fine con Merge(). I conteggi sono esatti e
+// non dipendono dal numero di thread; le somme per media/RMS possono
+// differire solo per l'arrotondamento dell'ordine di somma.
+//
+// La conversione in TH1F (contenuti, entries, statistiche) è fatta solo
+// all'uscita, nel codice ROOT (vedi ToTH1F e MakeTH1F in RootSink.h).
+// =====================================================================
+
+namespace mulife {
+
+class FixedHistogram {
+public:
+    FixedHistogram() = default;
+
+    FixedHistogram(int nbins, double xmin, double xmax)
+        : nbins_(nbins), xmin_(xmin), xmax_(xmax),
+          counts_((std::size_t)nbins + 2, 0u) {}
+
+    // Stesso bin di TAxis::FindBin (stessa formula, stessi arrotondamenti)
+    int FindBin(double x) const
+    {
+        if (x < xmin_) return 0;
+        if (!(x < xmax_)) return nbins_ + 1;
+        return 1 + (int)(nbins_ * (x - xmin_) / (xmax_ - xmin_));
+    }
+
+    void Fill(double x)
+    {
+        int b = FindBin(x);
+        counts_[(std::size_t)b] += 1u;
+        ++entries_;
+        // come TH1::Fill, le statistiche contano solo i bin nell'intervallo
+        if (b > 0 && b <= nbins_) {
+            sumw_   += 1.0;
+            sumwx_  += x;
+            sumwx2_ += x * x;
+        }
+    }
+
+    // n volte lo stesso valore
+    void Fill(double x, std::uint64_t n)
+    {
+        int b = FindBin(x);
+        counts_[(std::size_t)b] += n;
+        entries_ += n;
+        if (b > 0 && b <= nbins_) {
+            sumw_   += (double)n;
+            sumwx_  += (double)n * x;
+            sumwx2_ += (double)n * x * x;
+        }
+    }
+
+    // Somma di un istogramma con lo stesso binning
+    void Add(const FixedHistogram& o)
+    {
+        for (std::size_t i = 0; i < counts_.size() && i < o.counts_.size(); ++i) {
+            counts_[i] += o.counts_[i];
+        }
+        entries_ += o.entries_;
+        sumw_    += o.sumw_;
+        sumwx_   += o.sumwx_;
+        sumwx2_  += o.sumwx2_;
+    }
+
+    void Reset()
+    {
+        std::fill(counts_.begin(), counts_.end(), 0u);
+        entries_ = 0;
+        sumw_ = sumwx_ = sumwx2_ = 0.0;
+    }
+
+    int           NBins()   const { return nbins_; }
+    double        XMin()    const { return xmin_; }
+    double        XMax()    const { return xmax_; }
+    std::uint64_t Entries() const { return entries_; }
+
+    // Contenuto del bin (0 = underflow, nbins+1 = overflow)
+    std::uint64_t BinContent(int bin) const { return counts_[(std::size_t)bin]; }
+
+    // Media e deviazione standard dei valori nell'intervallo, come
+    // TH1::GetMean e TH1::GetRMS
+    double Mean() const { return (sumw_ > 0.0) ? sumwx_ / sumw_ : 0.0; }
+
+    double StdDev() const
+    {
+        if (sumw_ <= 0.0) return 0.0;
+        double m = sumwx_ / sumw_;
+        double v = sumwx2_ / sumw_ - m * m;
+        return (v > 0.0) ? std::sqrt(v) : 0.0;
+    }
+
+    // Valori dentro [xmin, xmax) (senza under/overflow)
+    double InRange() const { return sumw_; }
+
+    // { sumw, sumw2, sumwx, sumwx2 } nell'ordine di TH1::GetStats
+    // (pesi unitari: sumw2 = sumw)
+    void GetStats(double stats[4]) const
+    {
+        stats[0] = sumw_;
+        stats[1] = sumw_;
+        stats[2] = sumwx_;
+        stats[3] = sumwx2_;
+    }
+
+private:
+    int                        nbins_  = 0;
+    double                     xmin_   = 0.0;
+    double                     xmax_   = 1.0;
+    std::vector<std::uint64_t> counts_;
+    std::uint64_t              entries_ = 0;
+    double                     sumw_    = 0.0;
+    double                     sumwx_   = 0.0;
+    double                     sumwx2_  = 0.0;
+};
+
+// hDecay e hDecay_B8 … hDecay_B11 in versione FixedHistogram
+struct DecaySpectra {
+    FixedHistogram all;
+    FixedHistogram pmt[4];   // stop con PMT 8, 9, 10, 11 del blocco
+
+    DecaySpectra() = default;
+
+    DecaySpectra(int nbins, double tmin, double tmax)
+        : all(nbins, tmin, tmax)
+    {
+        for (FixedHistogram& h : pmt) h = FixedHistogram(nbins, tmin, tmax);
+    }
+
+    void Fill(double dt, unsigned int stopBlocks)
+    {
+        all.Fill(dt);
+        if (stopBlocks & BIT_B8)  pmt[0].Fill(dt);
+        if (stopBlocks & BIT_B9)  pmt[1].Fill(dt);
+        if (stopBlocks & BIT_B10) pmt[2].Fill(dt);
+        if (stopBlocks & BIT_B11) pmt[3].Fill(dt);
+    }
+
+    void Add(const DecaySpectra& o)
+    {
+        all.Add(o.all);
+        for (int k = 0; k < 4; ++k) pmt[k].Add(o.pmt[k]);
+    }
+    void Reset()
+    {
+        all.Reset();
+        for (FixedHistogram& h : pmt) h.Reset();
+    }
+};
+
+// Una copia di T per thread; T deve avere Add(const T&)
+template <class T>
+class ShardedHistogram {
+public:
+    ShardedHistogram(unsigned int nThreads, const T& proto)
+        : shards_(nThreads > 0 ? nThreads : 1)
+    {
+        for (Shard& s : shards_) s.h = proto;
+    }
+
+    // Copia del thread: da usare solo dal thread numero thread
+    T& Local(unsigned int thread) { return shards_[thread].h; }
+
+    // Somma delle copie, nell'ordine dei thread
+    T Merge() const
+    {
+        T out = shards_[0].h;
+        for (std::size_t k = 1; k < shards_.size(); ++k) out.Add(shards_[k].h);
+        return out;
+    }
+
+private:
+    // allineamento a 64 byte: i contatori di thread diversi non
+    // condividono linee di cache
+    struct alignas(64) Shard {
+        T h;
+    };
+    std::vector<Shard> shards_;
+};
+
+} // namespace mulife
+
+#endif // MULIFE_HISTOGRAM_H
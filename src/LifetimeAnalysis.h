@@ -0,0 +1,213 @@
+#ifndef MULIFE_LIFETIMEANALYSIS_H
+#define MULIFE_LIFETIMEANALYSIS_H
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "Histogram.h"
+#include "LifetimeFit.h"
+#include "PairingEngine.h"
+#include "Pipeline.h"
+#include "TakeAnalysis.h"
+
+// =====================================================================
+//              ANALISI COMPLETA DELLA VITA MEDIA (senza ROOT)
+// =====================================================================
+//
+// AnalyzeLifetime fa tutto quello che serve a Mu_life_new tranne
+// l'output: pairing (in streaming, in parallelo o in pipeline),
+// istogrammi dt totale e per PMT, fit unbinned. Il risultato
+// (LifetimeReport) è poi passato a uno o più "sink":
+//   - stampa dei risultati (mulife, macro);
+//   - RootSink.h: TH1F, fit binned con TF1 e file .root (facoltativo);
+//   - qualunque altro consumatore, ad es. il processo di acquisizione;
+//   - WriteLifetimeJson: riepilogo leggibile da programma (conteggi,
+//     esiti degli START, tempi per stadio, fit) per il monitoraggio
+//     del DAQ.
+// =====================================================================
+
+namespace mulife {
+
+struct LifetimeConfig {
+    PairingParams params;            // finestre del pairing; tmin/tmax anche per istogrammi e fit
+    int           nbins    = 80;
+    int           nThreads = 1;      // 1 = streaming, 0 = tutti i core
+    bool          pipeline = false;  // lettura/decodifica/pairing su thread separati
+};
+
+struct LifetimeReport {
+    TakeResult        take;          // dt e maschere delle coppie, conteggi
+    DecaySpectra      spectra;       // hDecay e hDecay_B8 … B11
+    LifetimeFitResult ml;            // fit unbinned
+    bool              mlOk = false;
+    PipelineStats     pipeline;      // solo con config.pipeline
+    double            fitSec   = 0.0;   // durata del fit unbinned [s]
+    double            totalSec = 0.0;   // durata di AnalyzeLifetime [s]
+};
+
+// Ritorna false se il file non può essere aperto
+inline bool AnalyzeLifetime(const char* path, const LifetimeConfig& config,
+                            LifetimeReport& rep)
+{
+    detail::StageClock::time_point tStart = detail::StageClock::now();
+    const PairingParams& p = config.params;
+    rep = LifetimeReport();
+    rep.spectra = DecaySpectra(config.nbins, p.tmin, p.tmax);
+
+    bool ok = config.pipeline
+        ? AnalyzeTakePipelined(path, p, rep.take,
+                               [&](double dt, unsigned int sb) { rep.spectra.Fill(dt, sb); },
+                               &rep.pipeline)
+        : AnalyzeTake(path, p, rep.take, config.nThreads, &rep.spectra);
+    if (!ok) return false;
+
+    detail::StageClock::time_point t0 = detail::StageClock::now();
+    if (!rep.take.dt_values.empty()) {
+        rep.mlOk = FitLifetimeUnbinned(rep.take.dt_values, p.tmin, p.tmax, rep.ml);
+    }
+    rep.fitSec   = detail::SecondsSince(t0);
+    rep.totalSec = detail::SecondsSince(tStart);
+    return true;
+}
+
+namespace detail {
+
+// Stringa JSON con le virgolette e i caratteri speciali protetti
+inline std::string JsonString(const std::string& in)
+{
+    std::string out = "\"";
+    for (char c : in) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if ((unsigned char)c < 0x20) {
+            char buf[8];
+            std::snprintf(buf, sizeof(buf), "\\u%04x", (unsigned int)(unsigned char)c);
+            out += buf;
+        } else {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+// Numero JSON (NaN e infiniti non sono ammessi: null)
+inline std::string JsonNumber(double x)
+{
+    if (!std::isfinite(x)) return "null";
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.10g", x);
+    return buf;
+}
+
+} // namespace detail
+
+// Riepilogo JSON di un'analisi: un oggetto con file, modalità,
+// parametri, conteggi, esiti degli START, tempi per stadio e fit
+inline void WriteLifetimeJson(std::ostream& os, const LifetimeConfig& config,
+                              const LifetimeReport& rep)
+{
+    using detail::JsonNumber;
+    const PairingParams&   p = config.params;
+    const PairingSummary&  s = rep.take.summary;
+    const PairingCounters& c = s.counters;
+    const char* mode = config.pipeline ? "pipeline" : (config.nThreads == 1 ? "stream" : "parallel");
+
+    os << "{\n"
+       << "  \"file\": " << detail::JsonString(rep.take.path) << ",\n"
+       << "  \"mode\": \"" << mode << "\",\n"
+       << "  \"threads\": " << config.nThreads << ",\n"
+       << "  \"params\": {"
+       << "\"earlyStopMaxEvents\": " << p.earlyStopMaxEvents
+       << ", \"finalStopMaxUs\": " << JsonNumber(p.finalStopMaxUs)
+       << ", \"earlyBlockWindow\": " << p.earlyBlockWindow
+       << ", \"finalBlockWindow\": " << p.finalBlockWindow
+       << ", \"tmin\": " << JsonNumber(p.tmin)
+       << ", \"tmax\": " << JsonNumber(p.tmax)
+       << ", \"tickUs\": " << JsonNumber(p.tickUs) << "},\n"
+       << "  \"counts\": {"
+       << "\"rows\": " << s.rows
+       << ", \"events\": " << s.events
+       << ", \"pairs\": " << s.pairs << "},\n"
+       << "  \"starts\": {"
+       << "\"total\": " << c.starts
+       << ", \"accepted\": " << c.accepted
+       << ", \"newStartEarly\": " << c.newStartEarly
+       << ", \"noEarlyStop\": " << c.noEarlyStop
+       << ", \"newStartFinal\": " << c.newStartFinal
+       << ", \"noFinalStop\": " << c.noFinalStop
+       << ", \"outOfWindow\": " << c.outOfWindow
+       << ", \"unfinished\": " << c.unfinished << "},\n"
+       << "  \"timeSec\": {"
+       << "\"read\": " << JsonNumber(s.times.read)
+       << ", \"decode\": " << JsonNumber(s.times.decode)
+       << ", \"pair\": " << JsonNumber(s.times.pair)
+       << ", \"fill\": " << JsonNumber(s.times.sink)
+       << ", \"fit\": " << JsonNumber(rep.fitSec)
+       << ", \"total\": " << JsonNumber(rep.totalSec) << "},\n"
+       << "  \"fit\": {"
+       << "\"converged\": " << (rep.mlOk ? "true" : "false")
+       << ", \"tau\": " << JsonNumber(rep.ml.tau)
+       << ", \"tauErr\": " << JsonNumber(rep.ml.tauErr)
+       << ", \"bkgFrac\": " << JsonNumber(rep.ml.bkgFrac)
+       << ", \"bkgFracErr\": " << JsonNumber(rep.ml.bkgFracErr)
+       << ", \"nEvents\": " << rep.ml.nEvents << "}\n"
+       << "}\n";
+}
+
+// Tabella leggibile degli esiti degli START e dei tempi per stadio
+inline void WriteStartOutcomes(std::ostream& os, const PairingSummary& s)
+{
+    const PairingCounters& c = s.counters;
+    auto line = [&](const char* what, std::size_t n) {
+        double pct = (c.starts > 0) ? 100.0 * (double)n / (double)c.starts : 0.0;
+        char buf[128];
+        std::snprintf(buf, sizeof(buf), "  %-34s %10zu  (%5.1f%%)\n", what, n, pct);
+        os << buf;
+    };
+    os << "[INFO] Esito degli START:\n";
+    line("START totali", c.starts);
+    line("coppie accettate", c.accepted);
+    line("nuovo START prima dello stop imm.", c.newStartEarly);
+    line("nessuno stop immediato", c.noEarlyStop);
+    line("nuovo START prima dello STOP", c.newStartFinal);
+    line("nessuno STOP entro finalStopMaxUs", c.noFinalStop);
+    line("dt fuori da [tmin, tmax]", c.outOfWindow);
+    line("aperti a fine file", c.unfinished);
+
+    char buf[160];
+    std::snprintf(buf, sizeof(buf),
+                  "[INFO] Tempo per stadio [s]: lettura %.4f, decodifica %.4f, "
+                  "pairing %.4f, istogrammi %.4f\n",
+                  s.times.read, s.times.decode, s.times.pair, s.times.sink);
+    os << buf;
+}
+
+// Come sopra, su file. Ritorna false se il file non può essere scritto.
+inline bool SaveLifetimeJson(const char* path, const LifetimeConfig& config,
+                             const LifetimeReport& rep)
+{
+    std::ofstream out(path);
+    if (!out) return false;
+    WriteLifetimeJson(out, config, rep);
+    return (bool)out;
+}
+
+// Numero di stop per ogni combinazione di PMT del blocco (maschere ≠ 0)
+inline std::map<unsigned int, long long> CountStopCombos(const std::vector<unsigned int>& stopBlocks)
+{
+    std::map<unsigned int, long long> counts;
+    for (unsigned int sb : stopBlocks) {
+        if (sb != 0u) counts[sb]++;
+    }
+    return counts;
+}
+
+} // namespace mulife
+
+#endif // MULIFE_LIFETIMEANALYSIS_H
@@ -0,0 +1,236 @@
+#ifndef MULIFE_LIFETIMEFIT_H
+#define MULIFE_LIFETIMEFIT_H
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+// glibc dichiara le varianti SIMD di exp e log (libmvec) solo con
+// -ffast-math; qui le stesse dichiarazioni di <bits/math-vector.h>
+#if defined(MULIFE_OPENMP_SIMD) && defined(__GNUC__) && !defined(__clang__) && \
+    defined(__x86_64__) && defined(__GLIBC__) && !defined(__FAST_MATH__) &&   \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 22))
+extern "C" {
+__attribute__((__simd__("notinbranch"))) double exp(double) noexcept;
+__attribute__((__simd__("notinbranch"))) double log(double) noexcept;
+}
+#endif
+
+// =====================================================================
+//          FIT UNBINNED (MAX LIKELIHOOD) ESPONENZIALE + FONDO
+// =====================================================================
+//
+// Alternativa al fit di hDecay con TF1 "[0]*exp(-x/[1]) +[2]": il
+// risultato non dipende dal numero di bin e non serve ROOT.
+//
+// Sui tempi t_i in [tmin, tmax] la densità di probabilità è
+//
+//   p(t) = (1 - f) * exp(-t/tau) / (tau * E(tau))  +  f / (tmax - tmin)
+//   E(tau) = exp(-tmin/tau) - exp(-tmax/tau)
+//
+// con f = frazione di fondo piatto. Si minimizza
+// NLL(tau, f) = -sum_i ln p(t_i) con il metodo di Newton: gradiente ed
+// hessiana sono analitici e calcolati in un solo passaggio sui dati,
+// senza branch. Con la build CMake (MULIFE_OPENMP_SIMD: -fopenmp-simd
+// -fno-math-errno) il loop è vettorializzato con "omp simd" e, con GCC
+// e glibc su x86-64, exp e log usano le versioni vettoriali di libmvec;
+// altrimenti (ad es. macro caricate in ROOT) resta il loop scalare.
+// Gli errori vengono dall'inversa dell'hessiana al minimo.
+//
+// Il legame con i parametri del TF1 (istogramma con nbins bin larghi w):
+//   B  ≈ f * N * w / (tmax - tmin)          [counts/bin]
+// =====================================================================
+
+namespace mulife {
+
+struct LifetimeFitResult {
+    double      tau        = 0.0;   // vita media [µs]
+    double      tauErr     = 0.0;
+    double      bkgFrac    = 0.0;   // frazione di fondo piatto
+    double      bkgFracErr = 0.0;
+    double      corr       = 0.0;   // correlazione tau–f
+    double      nll        = 0.0;   // -ln L al minimo
+    std::size_t nEvents    = 0;     // tempi usati (dentro la finestra)
+    int         iterations = 0;
+    bool        converged  = false;
+};
+
+namespace detail {
+
+// NLL, gradiente ed hessiana in (tau, f)
+struct ExpBkgSums {
+    double nll = 0.0;
+    double gTau = 0.0, gF = 0.0;
+    double hTauTau = 0.0, hTauF = 0.0, hFF = 0.0;
+};
+
+inline ExpBkgSums ExpBkgLikelihood(const double* t, std::size_t n,
+                                   double tau, double f, double tmin, double tmax)
+{
+    // Costanti per questo tau:
+    //   ln s(t)        = -t/tau - ln(tau E)
+    //   d ln s / dtau  = g(t)  = t/tau^2 - 1/tau - E'/E
+    //   d g / dtau     = g'(t) = -2t/tau^3 + 1/tau^2 - (E''/E - (E'/E)^2)
+    const double A   = std::exp(-tmin / tau);
+    const double Bq  = std::exp(-tmax / tau);
+    const double E   = A - Bq;
+    const double tau2 = tau * tau;
+    const double E1  = (tmin * A - tmax * Bq) / tau2;
+    const double E2  = (tmin * tmin * A - tmax * tmax * Bq) / (tau2 * tau2) - 2.0 * E1 / tau;
+    const double r1  = E1 / E;
+    const double gC  = -1.0 / tau - r1;                      // g(t) = t/tau^2 + gC
+    const double g1C = 1.0 / tau2 - (E2 / E - r1 * r1);      // g'(t) = -2t/tau^3 + g1C
+
+    const double sNorm = 1.0 / (tau * E);
+    const double b     = 1.0 / (tmax - tmin);
+    const double fs    = 1.0 - f;
+    const double invTau  = 1.0 / tau;
+    const double invTau2 = 1.0 / tau2;
+    const double m2Tau3  = -2.0 / (tau2 * tau);
+
+    double sLog = 0.0, sPf = 0.0, sPt = 0.0;
+    double sPfPf = 0.0, sPtPt = 0.0, sPfPt = 0.0, sPft = 0.0, sPtt = 0.0;
+
+#if defined(MULIFE_OPENMP_SIMD)
+#pragma omp simd reduction(+ : sLog, sPf, sPt, sPfPf, sPtPt, sPfPt, sPft, sPtt)
+#endif
+    for (std::size_t i = 0; i < n; ++i) {
+        const double ti = t[i];
+        const double s  = sNorm * std::exp(-ti * invTau);
+        const double g  = ti * invTau2 + gC;
+        const double g1 = ti * m2Tau3 + g1C;
+        const double p  = fs * s + f * b;
+        const double ip = 1.0 / p;
+
+        const double pf  = (b - s) * ip;              // (dp/df) / p
+        const double pt  = fs * s * g * ip;           // (dp/dtau) / p
+        const double pft = -s * g * ip;               // (d2p/df dtau) / p
+        const double ptt = fs * s * (g * g + g1) * ip;
+
+        sLog  += std::log(p);
+        sPf   += pf;
+        sPt   += pt;
+        sPfPf += pf * pf;
+        sPtPt += pt * pt;
+        sPfPt += pf * pt;
+        sPft  += pft;
+        sPtt  += ptt;
+    }
+
+    ExpBkgSums r;
+    r.nll     = -sLog;
+    r.gTau    = -sPt;
+    r.gF      = -sPf;
+    r.hTauTau = sPtPt - sPtt;
+    r.hTauF   = sPfPt - sPft;
+    r.hFF     = sPfPf;
+    return r;
+}
+
+} // namespace detail
+
+// Fit sui tempi t[0..n), che devono essere già tutti in [tmin, tmax].
+// tauStart e fStart sono i valori di partenza (fStart < 0 → stima dalla
+// coda della distribuzione). Ritorna false se il minimo non viene trovato.
+inline bool FitLifetimeUnbinned(const double* t, std::size_t n,
+                                double tmin, double tmax,
+                                LifetimeFitResult& res,
+                                double tauStart = 2.2, double fStart = -1.0)
+{
+    res = LifetimeFitResult();
+    res.nEvents = n;
+    if (n < 2 || !(tmax > tmin)) return false;
+
+    // Fondo di partenza: densità nell'ultimo quarto della finestra,
+    // dove l'esponenziale è trascurabile
+    if (fStart < 0.0) {
+        const double edge = tmin + 0.75 * (tmax - tmin);
+        std::size_t nTail = 0;
+        for (std::size_t i = 0; i < n; ++i) nTail += (t[i] >= edge) ? 1u : 0u;
+        fStart = 4.0 * (double)nTail / (double)n;
+    }
+
+    const double F_MIN = 1e-6;
+    const double F_MAX = 1.0 - 1e-6;
+    const double TAU_MIN = 1e-3 * (tmax - tmin);
+    const double TAU_MAX = 1e3 * (tmax - tmin);
+
+    double tau = std::fmin(std::fmax(tauStart, TAU_MIN), TAU_MAX);
+    double f   = std::fmin(std::fmax(fStart, 0.01), 0.99);
+
+    detail::ExpBkgSums S = detail::ExpBkgLikelihood(t, n, tau, f, tmin, tmax);
+
+    const int MAX_ITER = 100;
+    for (int it = 1; it <= MAX_ITER; ++it) {
+        res.iterations = it;
+
+        // passo di Newton; se l'hessiana non è definita positiva si
+        // ripiega sulla discesa del gradiente scalata con la diagonale
+        double det = S.hTauTau * S.hFF - S.hTauF * S.hTauF;
+        double dTau, dF;
+        if (S.hTauTau > 0.0 && S.hFF > 0.0 && det > 0.0) {
+            dTau = -( S.hFF * S.gTau - S.hTauF * S.gF) / det;
+            dF   = -(-S.hTauF * S.gTau + S.hTauTau * S.gF) / det;
+        } else {
+            dTau = -S.gTau / std::fmax(std::fabs(S.hTauTau), 1.0);
+            dF   = -S.gF   / std::fmax(std::fabs(S.hFF), 1.0);
+        }
+
+        // passo dimezzato finché la NLL scende (e i parametri restano validi)
+        double step = 1.0;
+        bool   moved = false;
+        detail::ExpBkgSums trial;
+        double tauNew = tau, fNew = f;
+        for (int k = 0; k < 40; ++k, step *= 0.5) {
+            tauNew = std::fmin(std::fmax(tau + step * dTau, TAU_MIN), TAU_MAX);
+            fNew   = std::fmin(std::fmax(f + step * dF, F_MIN), F_MAX);
+            trial  = detail::ExpBkgLikelihood(t, n, tauNew, fNew, tmin, tmax);
+            if (trial.nll <= S.nll) { moved = true; break; }
+        }
+
+        const double change = std::fabs(tauNew - tau) + std::fabs(fNew - f);
+        if (moved) {
+            tau = tauNew;
+            f   = fNew;
+            S   = trial;
+        }
+        if (!moved || change < 1e-9 * (1.0 + tau)) {
+            res.converged = (S.hTauTau > 0.0 && S.hFF > 0.0 &&
+                             S.hTauTau * S.hFF - S.hTauF * S.hTauF > 0.0);
+            break;
+        }
+    }
+
+    // covarianza = inversa dell'hessiana di -ln L
+    const double det = S.hTauTau * S.hFF - S.hTauF * S.hTauF;
+    res.tau     = tau;
+    res.bkgFrac = f;
+    res.nll     = S.nll;
+    if (det > 0.0) {
+        const double vTau = S.hFF / det;
+        const double vF   = S.hTauTau / det;
+        const double cov  = -S.hTauF / det;
+        res.tauErr     = std::sqrt(vTau);
+        res.bkgFracErr = std::sqrt(vF);
+        res.corr       = cov / std::sqrt(vTau * vF);
+    }
+    return res.converged;
+}
+
+// Come sopra, scartando i tempi fuori da [tmin, tmax]
+inline bool FitLifetimeUnbinned(const std::vector<double>& dt_values,
+                                double tmin, double tmax,
+                                LifetimeFitResult& res,
+                                double tauStart = 2.2, double fStart = -1.0)
+{
+    std::vector<double> t;
+    t.reserve(dt_values.size());
+    for (double x : dt_values) {
+        if (x >= tmin && x <= tmax) t.push_back(x);
+    }
+    return FitLifetimeUnbinned(t.data(), t.size(), tmin, tmax, res, tauStart, fStart);
+}
+
+} // namespace mulife
+
+#endif // MULIFE_LIFETIMEFIT_H
@@ -0,0 +1,153 @@
+#ifndef MULIFE_LIFETIMETOYS_H
+#define MULIFE_LIFETIMETOYS_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "LifetimeFit.h"
+#include "Parallel.h"
+
+// =====================================================================
+//         BOOTSTRAP E TOY MONTE CARLO PER L'ERRORE SU TAU
+// =====================================================================
+//
+// Invece di fidarsi del solo errore del fit, si ripete il fit unbinned
+// (LifetimeFit.h) su molti campioni:
+//
+//   - bootstrap: n tempi estratti con rimessa dai dt misurati;
+//   - toy MC   : Poisson(n) tempi generati dal modello fittato
+//                (esponenziale troncata a [tmin, tmax] + fondo piatto).
+//
+// I campioni girano su tutti i core con ParallelFor. Ogni campione ha
+// il suo generatore, con seme derivato da (seed, indice del campione):
+// i risultati non dipendono dal numero di thread e si riproducono.
+// =====================================================================
+
+namespace mulife {
+
+struct ToyStudy {
+    std::vector<double> tau;         // tau fittato per ogni campione (NaN se il fit fallisce)
+    std::vector<double> pull;        // (tau - tauRef) / tauErr
+    double      tauRef    = 0.0;     // valore di riferimento (fit sui dati o verità dei toy)
+    double      mean      = 0.0;     // media dei tau fittati
+    double      rms       = 0.0;     // dispersione dei tau fittati (errore "vero")
+    double      bias      = 0.0;     // mean - tauRef
+    double      pullMean  = 0.0;
+    double      pullWidth = 0.0;     // ≈ 1 se l'errore del fit è corretto
+    std::size_t nFailed   = 0;       // fit non convergenti (esclusi dalle medie)
+};
+
+namespace detail {
+
+// Seme indipendente per ogni campione (SplitMix64)
+inline std::uint64_t ToySeed(std::uint64_t seed, std::uint64_t index)
+{
+    std::uint64_t z = seed + 0x9E3779B97F4A7C15ull * (index + 1);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// Media, dispersione, bias e pull sui fit riusciti
+inline void SummarizeToys(ToyStudy& st)
+{
+    double s = 0.0, s2 = 0.0, p = 0.0, p2 = 0.0;
+    std::size_t n = 0;
+    for (std::size_t k = 0; k < st.tau.size(); ++k) {
+        if (std::isnan(st.tau[k])) continue;
+        s  += st.tau[k];
+        s2 += st.tau[k] * st.tau[k];
+        p  += st.pull[k];
+        p2 += st.pull[k] * st.pull[k];
+        ++n;
+    }
+    st.nFailed = st.tau.size() - n;
+    if (n == 0) return;
+    st.mean      = s / n;
+    st.rms       = std::sqrt(std::fmax(s2 / n - st.mean * st.mean, 0.0));
+    st.bias      = st.mean - st.tauRef;
+    st.pullMean  = p / n;
+    st.pullWidth = std::sqrt(std::fmax(p2 / n - st.pullMean * st.pullMean, 0.0));
+}
+
+} // namespace detail
+
+// Bootstrap sui tempi t (già tutti in [tmin, tmax]); fit è il risultato
+// del fit sui dati, usato come riferimento e come punto di partenza.
+inline void BootstrapLifetime(const std::vector<double>& t, double tmin, double tmax,
+                              const LifetimeFitResult& fit, std::size_t nSamples,
+                              ToyStudy& st, unsigned int nThreads = 0,
+                              std::uint64_t seed = 12345)
+{
+    st = ToyStudy();
+    st.tauRef = fit.tau;
+    st.tau.assign(nSamples, 0.0);
+    st.pull.assign(nSamples, 0.0);
+    if (t.empty()) return;
+
+    if (nThreads == 0) nThreads = DefaultThreads();
+    std::vector<std::vector<double>> buffers(nThreads);
+
+    ParallelFor(nSamples, nThreads, [&](std::size_t k, unsigned int thread) {
+        std::mt19937_64 rng(detail::ToySeed(seed, k));
+        std::uniform_int_distribution<std::size_t> pick(0, t.size() - 1);
+
+        std::vector<double>& sample = buffers[thread];
+        sample.resize(t.size());
+        for (double& x : sample) x = t[pick(rng)];
+
+        LifetimeFitResult r;
+        bool ok = FitLifetimeUnbinned(sample.data(), sample.size(), tmin, tmax, r,
+                                      fit.tau, fit.bkgFrac);
+        st.tau[k]  = ok ? r.tau : NAN;
+        st.pull[k] = (ok && r.tauErr > 0.0) ? (r.tau - fit.tau) / r.tauErr : 0.0;
+    });
+
+    detail::SummarizeToys(st);
+}
+
+// Toy MC dal modello (tau, f) con in media nEvents tempi per campione
+inline void ToyMCLifetime(double tau, double bkgFrac, double nEvents,
+                          double tmin, double tmax, std::size_t nToys,
+                          ToyStudy& st, unsigned int nThreads = 0,
+                          std::uint64_t seed = 67890)
+{
+    st = ToyStudy();
+    st.tauRef = tau;
+    st.tau.assign(nToys, 0.0);
+    st.pull.assign(nToys, 0.0);
+
+    if (nThreads == 0) nThreads = DefaultThreads();
+    std::vector<std::vector<double>> buffers(nThreads);
+
+    // esponenziale troncata per inversione della cumulativa
+    const double span = 1.0 - std::exp(-(tmax - tmin) / tau);
+
+    ParallelFor(nToys, nThreads, [&](std::size_t k, unsigned int thread) {
+        std::mt19937_64 rng(detail::ToySeed(seed, k));
+        std::poisson_distribution<long long>   count(nEvents);
+        std::uniform_real_distribution<double> u(0.0, 1.0);
+
+        std::vector<double>& sample = buffers[thread];
+        sample.resize((std::size_t)count(rng));
+        for (double& x : sample) {
+            if (u(rng) < bkgFrac) x = tmin + (tmax - tmin) * u(rng);
+            else                  x = tmin - tau * std::log(1.0 - u(rng) * span);
+        }
+
+        LifetimeFitResult r;
+        bool ok = FitLifetimeUnbinned(sample.data(), sample.size(), tmin, tmax, r,
+                                      tau, bkgFrac);
+        st.tau[k]  = ok ? r.tau : NAN;
+        st.pull[k] = (ok && r.tauErr > 0.0) ? (r.tau - tau) / r.tauErr : 0.0;
+    });
+
+    detail::SummarizeToys(st);
+}
+
+} // namespace mulife
+
+#endif // MULIFE_LIFETIMETOYS_H
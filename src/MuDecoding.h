@@ -0,0 +1,238 @@
+#ifndef MULIFE_MUDECODING_H
+#define MULIFE_MUDECODING_H
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+// =====================================================================
+//                    COSTANTI HARDWARE / DECODIFICA
+// =====================================================================
+//
+// Colonna 1 (CH)  : channel word
+// Colonna 2 (CT)  : counter word
+//
+// Codifica canali (CH):
+//   bit0 (1)  : START
+//   bit1 (2)  : STOP generale (uscita dual timer stop)
+//   bit2 (4)  : PMT8  & gate
+//   bit3 (8)  : PMT9  & gate
+//   bit4 (16) : PMT10 & gate
+//   bit5 (32) : PMT11 & gate
+//   bit31     : parola di reset del contatore (2^31)
+//
+// Il counter è un contatore a 30 bit che conta tick di 5 ns.
+// Ogni volta che compare una parola di reset (bit31 = 1) il contatore
+// si azzera. Per ottenere il tempo assoluto bisogna sommare,
+// per ogni evento, un offset pari a (#reset visti)*2^30*tick.
+//
+// Internamente il tempo assoluto è un intero a 64 bit in tick:
+//   ticks = (#reset << 30) | counter
+// così le finestre del pairing sono confronti tra interi, esatti anche
+// dopo molti reset. I microsecondi compaiono solo all'uscita (dt delle
+// coppie, istogrammi):
+//   1 tick        = 5 ns  = 0.005 µs
+//   reset_t_us    = 2^30 * 0.005 µs ≈ 5.37·10^6 µs
+// =====================================================================
+
+namespace mulife {
+
+const unsigned int BIT_START = 1u;         // 1
+const unsigned int BIT_STOP  = 1u << 1;    // 2
+const unsigned int BIT_B8    = 1u << 2;    // 4
+const unsigned int BIT_B9    = 1u << 3;    // 8
+const unsigned int BIT_B10   = 1u << 4;    // 16
+const unsigned int BIT_B11   = 1u << 5;    // 32
+
+const unsigned int STOP_GENERIC_MASK = (BIT_STOP | BIT_B8 | BIT_B9 | BIT_B10 | BIT_B11);
+const unsigned int BLOCK_MASK        = (BIT_B8 | BIT_B9 | BIT_B10 | BIT_B11);
+
+const unsigned int RESET_FLAG        = (1u << 31);
+const unsigned int COUNTER_MASK      = 0x3FFFFFFF;   // 30 bit bassi
+const int          COUNTER_BITS      = 30;           // tick tra due reset = 2^30
+
+// Tick e reset in microsecondi (valori di default, vedi PairingParams::tickUs)
+const double tick_us    = 0.005;                             // 5 ns
+const double reset_t_us = (double)(1ULL << 30) * tick_us;    // offset per ogni reset
+
+// =====================================================================
+//               MAPPA DEI CANALI (configurata a compile time)
+// =====================================================================
+//
+// Decoder, bitmap e pairing sono template su un tipo "layout" che dice
+// dove stanno START, STOP, PMT del blocco, reset e counter nella
+// channel/counter word. Tutti i campi sono constexpr: ogni layout
+// genera la sua versione del codice, con le maschere come costanti
+// immediate (nessuna tabella letta a runtime nel ciclo caldo).
+//
+// BitLayout descrive un cablaggio "un bit per segnale"; per un setup con
+// i PMT del target collegati altrove basta un alias, ad es.
+//   using MyLayout = BitLayout<1u << 0, 1u << 1, 1u << 6, 1u << 7, 1u << 8, 1u << 9>;
+// Un layout può ridefinire Keep() per cambiare quali righe diventano
+// eventi (vedi DecayTimeLayout).
+//
+// Le maschere dei blocchi delle coppie (DecayPair::startBlocks,
+// stopBlocks) escono sempre nella codifica canonica BIT_B8 … BIT_B11,
+// qualunque sia il layout: istogrammi e statistiche non cambiano.
+
+template <unsigned int Start, unsigned int Stop,
+          unsigned int B8, unsigned int B9, unsigned int B10, unsigned int B11,
+          unsigned int Reset = (1u << 31), int CounterBits = 30>
+struct BitLayout {
+    static constexpr unsigned int START        = Start;
+    static constexpr unsigned int STOP         = Stop;
+    static constexpr unsigned int BLOCK_MASK   = B8 | B9 | B10 | B11;
+    static constexpr unsigned int STOP_GENERIC = Stop | BLOCK_MASK;
+    static constexpr unsigned int RESET        = Reset;
+    static constexpr bool         HAS_RESET    = (Reset != 0u);
+    static constexpr int          COUNTER_BITS = CounterBits;
+    static constexpr unsigned int COUNTER_MASK =
+        (CounterBits >= 32) ? ~0u : ((1u << CounterBits) - 1u);
+
+    static constexpr bool IsReset(unsigned int ch) { return (ch & Reset) != 0u; }
+
+    // Riga da tenere come evento (se non è un reset): almeno un bit significativo
+    static constexpr bool Keep(unsigned int ch) { return (ch & (Start | STOP_GENERIC)) != 0u; }
+
+    // Bit dei blocchi del layout → BIT_B8 … BIT_B11
+    static constexpr unsigned int CanonicalBlocks(unsigned int mask)
+    {
+        if constexpr (B8 == BIT_B8 && B9 == BIT_B9 && B10 == BIT_B10 && B11 == BIT_B11) {
+            return mask;
+        } else {
+            return ((mask & B8)  ? BIT_B8  : 0u) | ((mask & B9)  ? BIT_B9  : 0u) |
+                   ((mask & B10) ? BIT_B10 : 0u) | ((mask & B11) ? BIT_B11 : 0u);
+        }
+    }
+};
+
+// Layout di Mu_life5.cpp (quello descritto sopra)
+using Mu5Layout = BitLayout<BIT_START, BIT_STOP, BIT_B8, BIT_B9, BIT_B10, BIT_B11,
+                            RESET_FLAG, COUNTER_BITS>;
+
+// Layout di DecayTime.cpp: CH == 1 START, CH == 2 STOP, nessun PMT del
+// blocco, nessuna parola di reset (counter usato a 32 bit così com'è);
+// sono tenute tutte le righe con CH <= 2 (anche CH == 0), scartate le altre.
+struct DecayTimeLayout : BitLayout<1u, 2u, 0u, 0u, 0u, 0u, 0u, 32> {
+    static constexpr bool Keep(unsigned int ch) { return ch <= 2u; }
+};
+
+// Conversione di una durata in µs nel numero di tick interi più vicino
+// per difetto (floor) o per eccesso (ceil). Il piccolo margine assorbe
+// l'arrotondamento di divisioni esatte come 20 / 0.005.
+inline long long FloorTicks(double us, double tickUs)
+{
+    return (long long)std::floor(us / tickUs + 1e-9);
+}
+
+inline long long CeilTicks(double us, double tickUs)
+{
+    return (long long)std::ceil(us / tickUs - 1e-9);
+}
+
+// =====================================================================
+//                  EVENTI DECODIFICATI (structure of arrays)
+// =====================================================================
+//
+// Invece di un vettore di struct Event (indice, tempo, ch, due bool e
+// stopMask, ~32 byte con il padding) gli eventi sono tenuti in array
+// separati e contigui. Il pairing non guarda evento per evento: legge
+// le bitmap costruite da ch (EventBitmaps.h) e accede a tempo e channel
+// word solo attorno agli START e agli STOP. Il tempo è in tick interi.
+
+struct EventStore {
+    std::vector<long long>     ticks;   // tempo assoluto [tick]
+    std::vector<unsigned int>  ch;      // channel word "piena"
+    std::vector<std::size_t>   row;     // indice della riga nel file originale
+
+    std::size_t size() const { return ch.size(); }
+    bool empty() const { return ch.empty(); }
+
+    void clear()
+    {
+        ticks.clear();
+        ch.clear();
+        row.clear();
+    }
+
+    void reserve(std::size_t n)
+    {
+        ticks.reserve(n);
+        ch.reserve(n);
+        row.reserve(n);
+    }
+
+    void push_back(std::size_t r, long long t, unsigned int c)
+    {
+        ticks.push_back(t);
+        ch.push_back(c);
+        row.push_back(r);
+    }
+};
+
+inline bool IsResetWord(unsigned int ch) {
+    return Mu5Layout::IsReset(ch);
+}
+
+// =====================================================================
+//                 DECODER (righe CH CT -> EventStore)
+// =====================================================================
+//
+// Ricostruisce il tempo assoluto in tick, (n_reset << 30) | counter, e scarta
+// le righe prima del primo reset e quelle senza bit significativi.
+// Lo stato (reset visti, indice di riga) sopravvive tra una chiamata e
+// l'altra, così il file può essere passato a blocchi.
+// Con un layout senza reset il tempo è il counter stesso e si tengono
+// le righe fin dalla prima.
+
+template <class Layout>
+class BasicFifoDecoder {
+public:
+    BasicFifoDecoder() = default;
+
+    // Decoder che riparte dalla riga row, dopo aver già visto
+    // resetsBefore parole di reset (almeno una)
+    BasicFifoDecoder(std::size_t row, long long resetsBefore)
+        : n_reset_(Layout::HAS_RESET ? resetsBefore - 1 : 0),
+          seenFirstReset_(!Layout::HAS_RESET || resetsBefore > 0),
+          row_(row) {}
+
+    void Decode(const unsigned int* CH, const unsigned int* CT, std::size_t n,
+                EventStore& out)
+    {
+        for (std::size_t k = 0; k < n; ++k, ++row_) {
+            unsigned int ch = CH[k];
+
+            if (Layout::IsReset(ch)) {
+                seenFirstReset_ = true;
+                n_reset_ += 1;
+                continue;
+            }
+
+            // Eventi di buffer prima del primo reset: li ignoriamo
+            if (!seenFirstReset_) continue;
+
+            // Consideriamo solo eventi con almeno un bit significativo
+            if (!Layout::Keep(ch)) continue;
+
+            unsigned int ctr = (CT[k] & Layout::COUNTER_MASK);
+            long long ticks = (n_reset_ << Layout::COUNTER_BITS) | (long long)ctr;
+
+            out.push_back(row_, ticks, ch);
+        }
+    }
+
+    std::size_t Rows() const { return row_; }
+
+private:
+    // parte da -1, così il primo reset → offset 0 (0 se il layout non ha reset)
+    long long   n_reset_        = Layout::HAS_RESET ? -1 : 0;
+    bool        seenFirstReset_ = !Layout::HAS_RESET;
+    std::size_t row_            = 0;
+};
+
+using FifoDecoder = BasicFifoDecoder<Mu5Layout>;
+
+} // namespace mulife
+
+#endif // MULIFE_MUDECODING_H
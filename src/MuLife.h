@@ -0,0 +1,47 @@
+#ifndef MULIFE_MULIFE_H
+#define MULIFE_MULIFE_H
+
+// =====================================================================
+//                  CORE DI ANALISI MULIFE (senza ROOT)
+// =====================================================================
+//
+// Header unico per chi usa il core da un altro programma (ad es. il
+// processo di acquisizione): solo libreria standard, niente ROOT.
+//
+//   lettura      FifoReader.h, FifoBinary.h, OnlineAnalysis.h
+//   decodifica   MuDecoding.h
+//   pairing      PairingEngine.h, ParallelPairing.h, Pipeline.h,
+//                DecayTimePairing.h
+//   istogrammi   Histogram.h
+//   fit          LifetimeFit.h, LifetimeToys.h
+//   analisi      TakeAnalysis.h, LifetimeAnalysis.h, ClockCalibration.h,
+//                ChannelSkew.h, ParameterScan.h
+//   wavedump     WavedumpSpectrum.h (spettri dell'integratore, PMT08–11),
+//                WavePulses.h (ricerca degli impulsi)
+//   test         SyntheticFifo.h (flussi sintetici con verità nota)
+//
+// L'uscita ROOT è a parte, in RootSink.h.
+// =====================================================================
+
+#include "MuDecoding.h"
+#include "FifoReader.h"
+#include "FifoBinary.h"
+#include "EventBitmaps.h"
+#include "PairingEngine.h"
+#include "ParallelPairing.h"
+#include "DecayTimePairing.h"
+#include "Pipeline.h"
+#include "Histogram.h"
+#include "LifetimeFit.h"
+#include "LifetimeToys.h"
+#include "TakeAnalysis.h"
+#include "LifetimeAnalysis.h"
+#include "ClockCalibration.h"
+#include "ChannelSkew.h"
+#include "ParameterScan.h"
+#include "OnlineAnalysis.h"
+#include "SyntheticFifo.h"
+#include "WavedumpSpectrum.h"
+#include "WavePulses.h"
+
+#endif // MULIFE_MULIFE_H
@@ -1,9 +1,13 @@
 #include <iostream>
 #include <fstream>
 #include <vector>
+#include <map>
 #include <string>
 #include <cmath>
 #include <algorithm>
+#include <iomanip>
+#include <chrono>
+#include <thread>
 
 // ROOT
 #include "TH1F.h"
@@ -11,97 +15,61 @@
 #include "TF1.h"
 #include "TStyle.h"
 #include "TFile.h"
+#include "TSystem.h"
 
-// =====================================================================
-//                    COSTANTI HARDWARE / DECODIFICA
-// =====================================================================
-//
-// Colonna 1 (CH)  : channel word
-// Colonna 2 (CT)  : counter word
-//
-// Codifica canali (CH):
-//   bit0 (1)  : START
-//   bit1 (2)  : STOP generale (uscita dual timer stop)
-//   bit2 (4)  : PMT8  & gate
-//   bit3 (8)  : PMT9  & gate
-//   bit4 (16) : PMT10 & gate
-//   bit5 (32) : PMT11 & gate
-//   bit31     : parola di reset del contatore (2^31)
-//
-// Il counter è un contatore a 30 bit che conta tick di 5 ns.
-// Ogni volta che compare una parola di reset (bit31 = 1) il contatore
-// si azzera. Per ottenere il tempo assoluto bisogna sommare,
-// per ogni evento, un offset pari a (#reset visti)*2^30*tick.
-//
-// In questo macro useremo come unità di tempo i microsecondi.
-//   1 tick        = 5 ns  = 0.005 µs
-//   reset_t_us    = 2^30 * 0.005 µs ≈ 5.37·10^6 µs
-// =====================================================================
-
-const unsigned int BIT_START = 1u;         // 1
-const unsigned int BIT_STOP  = 1u << 1;    // 2
-const unsigned int BIT_B8    = 1u << 2;    // 4
-const unsigned int BIT_B9    = 1u << 3;    // 8
-const unsigned int BIT_B10   = 1u << 4;    // 16
-const unsigned int BIT_B11   = 1u << 5;    // 32
+// Calcolo senza ROOT (lettura, decodifica, pairing, istogrammi, fit)
+#include "MuLife.h"
 
-const unsigned int STOP_GENERIC_MASK = (BIT_STOP | BIT_B8 | BIT_B9 | BIT_B10 | BIT_B11);
-const unsigned int BLOCK_MASK        = (BIT_B8 | BIT_B9 | BIT_B10 | BIT_B11);
+// Uscita ROOT: TH1F, fit binned, file
+#include "RootSink.h"
 
-const unsigned int RESET_FLAG        = (1u << 31);
-const unsigned int COUNTER_MASK      = 0x3FFFFFFF;   // 30 bit bassi
-
-// Tick e reset in microsecondi
-const double tick_us    = 0.005;                             // 5 ns
-const double reset_t_us = (double)(1ULL << 30) * tick_us;    // offset per ogni reset
-
-// Parametri logici richiesti
-const int   EARLY_STOP_MAX_TICKS  = 10;     // stop "immediato" entro 10 eventi dopo lo start
-const double FINAL_STOP_MAX_US    = 20.0;   // stop fisico entro 20 µs dallo start
-const int   EARLY_BLOCK_WINDOW    = 2;      // ±2 eventi per stimare i blocchi dello stop "immediato"
-const int   FINAL_BLOCK_WINDOW    = 3;      // ±3 eventi per stimare i blocchi dello stop finale
-
-// =====================================================================
-//                      STRUTTURA EVENTO
-// =====================================================================
-
-struct Event {
-    std::size_t index;      // indice della riga nel file originale
-    double      t_us;       // tempo assoluto [µs]
-    unsigned int ch;        // channel word "piena"
-    bool isStart;
-    bool isStop;
-    unsigned int stopMask;  // ch & STOP_GENERIC_MASK
-
-    Event(std::size_t i, double t, unsigned int c)
-        : index(i),
-          t_us(t),
-          ch(c),
-          isStart((c & BIT_START) != 0u),
-          isStop((c & STOP_GENERIC_MASK) != 0u),
-          stopMask(c & STOP_GENERIC_MASK) {}
-};
-
-// =====================================================================
-//                        FUNZIONI DI SUPPORTO
-// =====================================================================
+using namespace mulife;
 
-inline bool IsResetWord(unsigned int ch) {
-    return (ch & RESET_FLAG) != 0u;
+// Tick del contatore dal file di calibrazione (Calibration in
+// DEONANO.cpp o "mulife calibration"), se c'è; altrimenti il tick
+// nominale, dall'header dei file binari (FifoBinary.h) o 5 ns
+void LoadCalibratedTick(const char* calibFile, const std::vector<std::string>& files, double& tickUs)
+{
+    FifoHeaderTickUs(files, tickUs);
+    if (calibFile != nullptr && calibFile[0] != '\0' && LoadTickUs(calibFile, tickUs)) {
+        std::cout << "[INFO] Tick da " << calibFile << ": " << tickUs << " µs\n";
+    } else {
+        std::cout << "[INFO] Tick nominale: " << tickUs << " µs\n";
+    }
 }
 
-// OR dei bit dei blocchi (8,9,10,11) in una finestra di eventi
-unsigned int CollectBlockMask(const std::vector<Event>& evs,
-                              int centerIndex,
-                              int halfWindow)
+// Tabella dei contatori della pipeline: throughput di ogni stadio e
+// occupazione media/massima delle code tra uno stadio e il successivo
+void PrintPipelineStats(const PipelineStats& st)
 {
-    unsigned int mask = 0u;
-    int iMin = std::max(0, centerIndex - halfWindow);
-    int iMax = std::min((int)evs.size() - 1, centerIndex + halfWindow);
-    for (int i = iMin; i <= iMax; ++i) {
-        mask |= (evs[i].ch & BLOCK_MASK);
-    }
-    return mask;
+    auto stage = [](const char* name, const char* unit, const StageStats& s) {
+        std::cout << "  " << std::left << std::setw(11) << name << std::right
+                  << std::setw(10) << s.items << " " << std::left << std::setw(7) << unit
+                  << std::right << std::fixed << std::setprecision(3)
+                  << "  lavoro " << std::setw(7) << s.busySec << " s"
+                  << "  attesa " << std::setw(7) << s.waitSec << " s"
+                  << std::setprecision(2)
+                  << "  " << std::setw(8) << s.ItemsPerSec() / 1e6 << " M/s\n";
+        std::cout.unsetf(std::ios::fixed);
+        std::cout << std::setprecision(6);
+    };
+    auto queue = [](const char* name, const QueueStats& q) {
+        std::cout << "  coda " << name
+                  << std::fixed << std::setprecision(2)
+                  << ": occupazione media " << q.MeanFill() << " / " << q.capacity
+                  << ",  massima " << q.maxFill << "\n";
+        std::cout.unsetf(std::ios::fixed);
+        std::cout << std::setprecision(6);
+    };
+
+    std::cout << "\n[INFO] Pipeline (tempo totale " << st.wallSec << " s):\n";
+    stage("lettura",    "righe",  st.read);
+    stage("decodifica", "eventi", st.decode);
+    stage("pairing",    "eventi", st.pair);
+    stage("istogrammi", "coppie", st.sink);
+    queue("righe→decodifica", st.rowsQueue);
+    queue("eventi→pairing", st.eventsQueue);
+    queue("coppie→istogrammi", st.pairsQueue);
 }
 
 // =====================================================================
@@ -111,7 +79,11 @@ unsigned int CollectBlockMask(const std::vector<Event>& evs,
 void Mu_life_new(const char* filename = "FIFOread_Take5.txt",
                  int nbins = 80,
                  double tmin = 0.0,
-                 double tmax = 20.0)
+                 double tmax = 20.0,
+                 int nThreads = 1,
+                 bool pipeline = false,
+                 const char* statsFile = "Mu_life_new.json",
+                 const char* calibFile = "ClockCalibration.txt")
 {
     std::cout << "\n============================================\n";
     std::cout << "[Mu_life_new] File: " << filename << "\n";
@@ -120,214 +92,77 @@ void Mu_life_new(const char* filename = "FIFOread_Take5.txt",
     std::cout << "============================================\n";
 
     // ------------------------------------------------------------
-    // 1) Lettura file grezzo
+    // 1) Lettura, decodifica e pairing START → STOP
     // ------------------------------------------------------------
-    std::ifstream fin(filename);
-    if (!fin.is_open()) {
+    //
+    // Con nThreads == 1 il file è letto a blocchi: righe → eventi con
+    // tempo assoluto → macchina a stati START → stop "immediato" →
+    // STOP finale (vedi PairingEngine.h). In memoria restano solo le
+    // coppie.
+    //
+    // Con nThreads != 1 (0 = tutti i core) il file è caricato in memoria
+    // e diviso ai reset del contatore, con un worker per blocco
+    // (vedi ParallelPairing.h). Le coppie sono le stesse.
+    //
+    // Con pipeline = true lettura, decodifica e pairing girano su tre
+    // thread collegati da code lock-free e gli istogrammi si riempiono
+    // qui mentre il file viene ancora letto (vedi Pipeline.h).
+    //
+    // In tutti i casi il calcolo (pairing, istogrammi, fit unbinned) è
+    // fatto senza ROOT da AnalyzeLifetime (LifetimeAnalysis.h); i TH1F
+    // sono creati solo per il fit binned e l'uscita (RootSink.h).
+    LifetimeConfig config;
+    config.params.tmin = tmin;
+    config.params.tmax = tmax;
+    config.nbins    = nbins;
+    config.nThreads = nThreads;
+    config.pipeline = pipeline;
+
+    LoadCalibratedTick(calibFile, {filename}, config.params.tickUs);
+
+    LifetimeReport rep;
+    bool ok = AnalyzeLifetime(filename, config, rep);
+
+    const std::vector<double>& dt_values = rep.take.dt_values;
+    const PairingSummary&      summary   = rep.take.summary;
+
+    if (!ok) {
         std::cerr << "[ERRORE] Impossibile aprire il file " << filename << "\n";
         return;
     }
 
-    std::vector<unsigned int> CH;
-    std::vector<unsigned int> CT;
-    CH.reserve(200000);
-    CT.reserve(200000);
-
-    unsigned int ch_tmp = 0;
-    unsigned int ct_tmp = 0;
-    while (fin >> ch_tmp >> ct_tmp) {
-        CH.push_back(ch_tmp);
-        CT.push_back(ct_tmp);
-    }
-    fin.close();
-
-    if (CH.empty() || CH.size() != CT.size()) {
+    if (summary.rows == 0) {
         std::cerr << "[ERRORE] File vuoto o colonne di lunghezza diversa.\n";
         return;
     }
 
-    std::cout << "[INFO] Righe lette: " << CH.size() << "\n";
-
-    // ------------------------------------------------------------
-    // 2) Costruzione vettore di Event con tempo assoluto
-    // ------------------------------------------------------------
-    std::vector<Event> events;
-    events.reserve(CH.size());
-
-    long long n_reset = -1;     // parte da -1, così il primo reset → offset 0
-    bool seenFirstReset = false;
-
-    for (std::size_t i = 0; i < CH.size(); ++i) {
-        unsigned int ch = CH[i];
-        unsigned int ct = CT[i];
-
-        bool isReset = IsResetWord(ch);
-        if (isReset) {
-            seenFirstReset = true;
-            n_reset += 1;
-            continue;
-        }
-
-        if (!seenFirstReset) {
-            // Eventi di buffer prima del primo reset: li ignoriamo
-            continue;
-        }
-
-        unsigned int ctr = (ct & COUNTER_MASK);
-        double t_us = (double)ctr * tick_us + (double)n_reset * reset_t_us;
-
-        // Consideriamo solo eventi con almeno un bit significativo
-        unsigned int mask = ch & (BIT_START | STOP_GENERIC_MASK);
-        if (mask == 0u) continue;
-
-        events.emplace_back(i, t_us, ch);
-    }
-
-    std::cout << "[INFO] Eventi dopo il primo reset: " << events.size() << "\n";
-    if (events.empty()) {
+    std::cout << "[INFO] Righe lette: " << summary.rows << "\n";
+    std::cout << "[INFO] Eventi dopo il primo reset: " << summary.events << "\n";
+    if (summary.events == 0) {
         std::cerr << "[ERRORE] Nessun evento utile dopo il primo reset.\n";
         return;
     }
 
-    // ------------------------------------------------------------
-    // 3) Loop principale: pairing START → STOP (senza goto)
-    // ------------------------------------------------------------
-    std::vector<double> dt_values;          // tempi di decadimento
-    std::vector<unsigned int> startBlocks;  // blocchi allo stop "immediato"
-    std::vector<unsigned int> stopBlocks;   // blocchi allo stop finale
-
-    dt_values.reserve(10000);
-    startBlocks.reserve(10000);
-    stopBlocks.reserve(10000);
-
-    std::size_t N = events.size();
-    std::size_t i = 0;      // indice principale sugli eventi
-
-    while (i < N) {
-        const Event& evStart = events[i];
-
-        if (!evStart.isStart) {
-            ++i;
-            continue;
-        }
-
-        std::size_t idxStart = i;
-        double tStart = evStart.t_us;
-
-        // Flag per sapere se scartiamo lo start a metà procedura
-        bool discardThisStart = false;
-
-        // 1) Cerca stop "immediato" entro EARLY_STOP_MAX_TICKS eventi
-        bool foundEarlyStop = false;
-        std::size_t idxEarlyStop = 0;
-
-        for (std::size_t j = idxStart + 1;
-             j < N && j <= idxStart + (std::size_t)EARLY_STOP_MAX_TICKS;
-             ++j) {
-
-            const Event& ev2 = events[j];
-
-            // Se nel mezzo appare un nuovo START → scartiamo quello vecchio
-            if (ev2.isStart) {
-                // ripartiamo a elaborare da questo nuovo start
-                i = j;
-                discardThisStart = true;
-                break;
-            }
-
-            // stop generico: almeno un bit tra 2,4,8,16,32
-            if ((ev2.stopMask & STOP_GENERIC_MASK) != 0u) {
-                foundEarlyStop = true;
-                idxEarlyStop = j;
-                break;
-            }
-        }
-
-        if (discardThisStart) {
-            // passiamo direttamente al prossimo ciclo del while (nuovo start)
-            continue;
-        }
-
-        if (!foundEarlyStop) {
-            // nessun stop immediato → scarta questo start e vai avanti
-            ++i;
-            continue;
-        }
-
-        // blocchi attivi intorno allo stop immediato
-        unsigned int earlyBlockMask =
-            CollectBlockMask(events, (int)idxEarlyStop, EARLY_BLOCK_WINDOW);
-
-        // 2) Cerca lo STOP FINALE (bit2 acceso) entro 20 µs dallo start
-        bool foundFinalStop = false;
-        std::size_t idxFinalStop = 0;
-
-        for (std::size_t j = idxEarlyStop + 1; j < N; ++j) {
-            const Event& ev2 = events[j];
-
-            double dt_tmp = ev2.t_us - tStart;
-            if (dt_tmp > FINAL_STOP_MAX_US) {
-                // oltre la finestra di 20 µs → stop non trovato
-                break;
-            }
-
-            // se appare un nuovo START prima dello stop finale → scartiamo
-            if (ev2.isStart) {
-                i = j;  // ripartiamo da questo nuovo start
-                discardThisStart = true;
-                break;
-            }
-
-            // STOP finale: richiediamo il bit2 (STOP generale)
-            if ((ev2.ch & BIT_STOP) != 0u) {
-                foundFinalStop = true;
-                idxFinalStop = j;
-                break;
-            }
-        }
-
-        if (discardThisStart) {
-            // abbiamo trovato un nuovo start nel mezzo: questo vecchio è scartato
-            continue;
-        }
-
-        if (!foundFinalStop) {
-            // nessun stop finale → scarta questo start e vai avanti
-            ++i;
-            continue;
-        }
-
-        // 3) Abbiamo una coppia START–STOP: calcola dt e blocchi dello stop finale
-        const Event& evStop = events[idxFinalStop];
-        double dt = evStop.t_us - tStart;
-
-        if (dt >= tmin && dt <= tmax) {
-            unsigned int finalBlockMask =
-                CollectBlockMask(events, (int)idxFinalStop, FINAL_BLOCK_WINDOW);
-
-            dt_values.push_back(dt);
-            startBlocks.push_back(earlyBlockMask);
-            stopBlocks.push_back(finalBlockMask);
-        }
-
-        // Dopo aver gestito questa coppia, ripartiamo dall'evento successivo allo stop
-        i = idxFinalStop + 1;
-    }
-
     std::cout << "[INFO] Coppie START–STOP accettate: "
               << dt_values.size() << "\n";
+    WriteStartOutcomes(std::cout, summary);
+    if (pipeline) PrintPipelineStats(rep.pipeline);
+
+    // Riepilogo JSON della corsa (conteggi, scarti, tempi per stadio, fit):
+    // statsFile = nullptr o "" per non scriverlo
+    if (statsFile != nullptr && statsFile[0] != '\0') {
+        if (SaveLifetimeJson(statsFile, config, rep)) {
+            std::cout << "[INFO] Riepilogo salvato in " << statsFile << "\n";
+        } else {
+            std::cerr << "[ERRORE] Impossibile scrivere il file " << statsFile << "\n";
+        }
+    }
 
     // ------------------------------------------------------------
     // Statistiche sulle combinazioni di PMT del blocco per gli stop
     // ------------------------------------------------------------
-    std::map<unsigned int, long long> comboCounts;
-
-    for (std::size_t k = 0; k < stopBlocks.size(); ++k) {
-        unsigned int sb = stopBlocks[k];
-        if (sb == 0u) continue;  // se per qualche motivo non c'è nessun PMT del blocco, ignora
-
-        comboCounts[sb]++;
-    }
+    // (le maschere senza nessun PMT del blocco sono ignorate)
+    std::map<unsigned int, long long> comboCounts = CountStopCombos(rep.take.stopBlocks);
 
     std::cout << "\n[INFO] Statistiche combinazioni PMT di stop (blocchi 8–11):\n";
     if (comboCounts.empty()) {
@@ -358,38 +193,16 @@ void Mu_life_new(const char* filename = "FIFOread_Take5.txt",
         return;
     }
 
-    // 4) Istogramma e fit esponenziale + fondo
+    // 2) Istogramma e fit esponenziale + fondo
     // ------------------------------------------------------------
-    TH1F* hDecay = new TH1F("hDecay",
-                            "Muon decay time; t_{decay} [#mu s]; Counts",
-                            nbins, tmin, tmax);
-
-    // Istogrammi separati per i diversi PMT del blocco
-    TH1F* hDecay_B8  = new TH1F("hDecay_B8",
-                                "Muon decay time (stop PMT 8); t_{decay} [#mu s]; Counts",
-                                nbins, tmin, tmax);
-    TH1F* hDecay_B9  = new TH1F("hDecay_B9",
-                                "Muon decay time (stop PMT 9); t_{decay} [#mu s]; Counts",
-                                nbins, tmin, tmax);
-    TH1F* hDecay_B10 = new TH1F("hDecay_B10",
-                                "Muon decay time (stop PMT 10); t_{decay} [#mu s]; Counts",
-                                nbins, tmin, tmax);
-    TH1F* hDecay_B11 = new TH1F("hDecay_B11",
-                                "Muon decay time (stop PMT 11); t_{decay} [#mu s]; Counts",
-                                nbins, tmin, tmax);
-
-    // Riempiamo l'istogramma totale e quelli per PMT in base alla maschera dei blocchi
-    for (std::size_t k = 0; k < dt_values.size(); ++k) {
-        double dt = dt_values[k];
-        unsigned int sb = (k < stopBlocks.size()) ? stopBlocks[k] : 0u;
-
-        hDecay->Fill(dt);
-
-        if (sb & BIT_B8)  hDecay_B8->Fill(dt);
-        if (sb & BIT_B9)  hDecay_B9->Fill(dt);
-        if (sb & BIT_B10) hDecay_B10->Fill(dt);
-        if (sb & BIT_B11) hDecay_B11->Fill(dt);
-    }
+    DecayHistos h = BookDecayHistos(nbins, tmin, tmax);
+    SpectraToHistos(rep.spectra, h);
+
+    TH1F* hDecay     = h.hDecay;
+    TH1F* hDecay_B8  = h.hDecay_B8;
+    TH1F* hDecay_B9  = h.hDecay_B9;
+    TH1F* hDecay_B10 = h.hDecay_B10;
+    TH1F* hDecay_B11 = h.hDecay_B11;
 
     std::cout << "[INFO] Entries istogramma totale: " << hDecay->GetEntries() << "\n";
     std::cout << "[INFO] Entries istogramma PMT8:  " << hDecay_B8->GetEntries() << "\n";
@@ -399,30 +212,7 @@ void Mu_life_new(const char* filename = "FIFOread_Take5.txt",
 
     gStyle->SetOptFit(1);
 
-    // Modello: N(t) = N0 * exp(-t/tau) + B
-    TF1* fExpBkg = new TF1("fExpBkg",
-                           "[0]*exp(-x/[1]) +[2]",
-                           tmin, tmax);
-    fExpBkg->SetParNames("N0", "tau", "B");
-
-    // Stime iniziali
-    fExpBkg->SetParameter(0, hDecay->GetMaximum());
-    fExpBkg->SetParameter(1, 2.2);   // µs, tempo di vita atteso
-
-    // (segue il resto del codice del fit come prima)
-
-
-    //Stima grezza del fondo costante dai bin di coda
-    double bkgGuess = 0.0;
-    int nb = hDecay->GetNbinsX();
-    int nTail = std::min(10, nb);
-    for (int ib = nb - nTail + 1; ib <= nb; ++ib) {
-      bkgGuess += hDecay->GetBinContent(ib);
-    }
-    bkgGuess /= (double)nTail;
-    fExpBkg->SetParameter(2, bkgGuess);
-
-    hDecay->Fit(fExpBkg, "LIR+");
+    TF1* fExpBkg = FitDecay(hDecay, tmin, tmax);
 
     double tau  = fExpBkg->GetParameter(1);
     double etau = fExpBkg->GetParError(1);
@@ -434,6 +224,23 @@ void Mu_life_new(const char* filename = "FIFOread_Take5.txt",
     std::cout << "B (fondo)= " << B    << " ± " << eB   << " counts/bin\n";
     std::cout << "==============================================\n";
 
+    // Fit unbinned (max likelihood) sugli stessi dt: non dipende da nbins
+    const LifetimeFitResult& ml = rep.ml;
+    if (rep.mlOk) {
+        double binW = (tmax - tmin) / nbins;
+        double Bml  = ml.bkgFrac * ml.nEvents * binW / (tmax - tmin);
+
+        std::cout << "\n============ FIT UNBINNED (max likelihood) ============\n";
+        std::cout << "Tau (µ)      = " << ml.tau << " ± " << ml.tauErr << " µs\n";
+        std::cout << "Fondo (fraz.)= " << ml.bkgFrac << " ± " << ml.bkgFracErr
+                  << "   (≈ " << Bml << " counts/bin)\n";
+        std::cout << "Correlazione = " << ml.corr << ",  eventi = " << ml.nEvents
+                  << ",  iterazioni = " << ml.iterations << "\n";
+        std::cout << "=======================================================\n";
+    } else {
+        std::cerr << "[ATTENZIONE] Il fit unbinned non converge.\n";
+    }
+
     TCanvas* c1 = new TCanvas("c1", "Muon lifetime", 800, 600);
     hDecay->Draw();
     fExpBkg->Draw("same");
@@ -453,11 +260,7 @@ void Mu_life_new(const char* filename = "FIFOread_Take5.txt",
     hDecay_B11->Draw();
 
     TFile* fout = new TFile("Mu_life_new.root", "RECREATE");
-    hDecay->Write();
-    hDecay_B8->Write();
-    hDecay_B9->Write();
-    hDecay_B10->Write();
-    hDecay_B11->Write();
+    WriteDecayHistos(h);
     fExpBkg->Write();
     c1->Write();
     c2->Write();
@@ -468,3 +271,433 @@ void Mu_life_new(const char* filename = "FIFOread_Take5.txt",
 
     std::cout << "[INFO] Risultati salvati in Mu_life_new.root\n";
 }
+
+// =====================================================================
+//                          MU_LIFE_BATCH
+// =====================================================================
+//
+// Analizza in un solo processo tutte le prese dati FIFOread_*.txt di
+// una cartella. I file sono letti e accoppiati in parallelo (un file
+// per thread, nThreads = 0 → tutti i core) e ogni worker riempie gli
+// istogrammi senza ROOT della sua presa (Histogram.h). Copia in TH1F e
+// fit sono poi fatti nel thread principale, perché gli oggetti ROOT non
+// sono thread-safe.
+//
+// Nel file di uscita:
+//   <TakeN>/hDecay, hDecay_B8 … hDecay_B11, fExpBkg_<TakeN>
+//   hDecay, hDecay_B8 … hDecay_B11, fExpBkg   (somma di tutte le prese)
+// =====================================================================
+
+void Mu_life_batch(const char* dir = "data/Take",
+                   int nbins = 80,
+                   double tmin = 0.0,
+                   double tmax = 20.0,
+                   const char* output = "Mu_life_batch.root",
+                   int nThreads = 0,
+                   const char* calibFile = "ClockCalibration.txt")
+{
+    std::vector<std::string> files = FindTakes(dir);
+
+    std::cout << "\n============================================\n";
+    std::cout << "[Mu_life_batch] Cartella: " << dir
+              << " (" << files.size() << " file)\n";
+    std::cout << "[Mu_life_batch] Finestra istogramma dt: ["
+              << tmin << ", " << tmax << "] µs\n";
+    std::cout << "============================================\n";
+
+    if (files.empty()) {
+        std::cerr << "[ERRORE] Nessun file FIFOread_*.txt in " << dir << "\n";
+        return;
+    }
+
+    // ------------------------------------------------------------
+    // 1) Pairing di tutte le prese, un file per thread
+    // ------------------------------------------------------------
+    PairingParams params;
+    params.tmin = tmin;
+    params.tmax = tmax;
+    LoadCalibratedTick(calibFile, files, params.tickUs);
+
+    std::vector<TakeResult>   takes(files.size());
+    std::vector<DecaySpectra> spectra(files.size(), DecaySpectra(nbins, tmin, tmax));
+    std::vector<char>         ok(files.size(), 0);
+
+    ParallelFor(files.size(), (unsigned int)std::max(nThreads, 0),
+                [&](std::size_t k, unsigned int) {
+                    ok[k] = AnalyzeTake(files[k].c_str(), params, takes[k], 1, &spectra[k]) ? 1 : 0;
+                });
+
+    // ------------------------------------------------------------
+    // 2) Istogrammi e fit per presa, più la somma
+    // ------------------------------------------------------------
+    TFile* fout = new TFile(output, "RECREATE");
+
+    fout->cd();
+    DecayHistos merged = BookDecayHistos(nbins, tmin, tmax);
+
+    std::cout << "\n  " << std::left << std::setw(10) << "Presa" << std::right
+              << std::setw(10) << "Righe" << std::setw(10) << "Coppie" << "   Tau [µs]\n";
+    for (std::size_t k = 0; k < files.size(); ++k) {
+        std::string label = TakeLabel(files[k]);
+
+        if (!ok[k]) {
+            std::cerr << "[ERRORE] Impossibile aprire il file " << files[k] << "\n";
+            continue;
+        }
+
+        TDirectory* d = fout->mkdir(label.c_str());
+        d->cd();
+
+        DecayHistos h = BookDecayHistos(nbins, tmin, tmax);
+        SpectraToHistos(spectra[k], h);
+
+        merged.hDecay->Add(h.hDecay);
+        merged.hDecay_B8->Add(h.hDecay_B8);
+        merged.hDecay_B9->Add(h.hDecay_B9);
+        merged.hDecay_B10->Add(h.hDecay_B10);
+        merged.hDecay_B11->Add(h.hDecay_B11);
+
+        std::cout << "  " << std::left << std::setw(10) << label << std::right
+                  << std::setw(10) << takes[k].summary.rows
+                  << std::setw(10) << takes[k].dt_values.size();
+
+        if (h.hDecay->GetEntries() > 0) {
+            std::string fname = "fExpBkg_" + label;
+            TF1* f = FitDecay(h.hDecay, tmin, tmax, fname.c_str());
+            std::cout << "   " << f->GetParameter(1) << " ± " << f->GetParError(1);
+            f->Write();
+        }
+        std::cout << "\n";
+
+        WriteDecayHistos(h);
+    }
+
+    fout->cd();
+    if (merged.hDecay->GetEntries() > 0) {
+        TF1* f = FitDecay(merged.hDecay, tmin, tmax);
+
+        std::cout << "\n================ RISULTATI FIT (somma) ================\n";
+        std::cout << "Tau (µ)  = " << f->GetParameter(1) << " ± " << f->GetParError(1) << " µs\n";
+        std::cout << "B (fondo)= " << f->GetParameter(2) << " ± " << f->GetParError(2) << " counts/bin\n";
+        std::cout << "=======================================================\n";
+        f->Write();
+    }
+    WriteDecayHistos(merged);
+    fout->Close();
+
+    std::cout << "[INFO] Risultati salvati in " << output << "\n";
+}
+
+// =====================================================================
+//                 MU_LIFE_TOYS (bootstrap e toy MC)
+// =====================================================================
+//
+// Fit unbinned di una presa dati, poi:
+//   - nBoot campioni bootstrap dei dt  → dispersione "vera" di tau;
+//   - nToys toy MC dal modello fittato → bias del fit e larghezza del
+//     pull (≈ 1 se l'errore del fit è affidabile).
+// I fit girano su nThreads core (0 = tutti, vedi LifetimeToys.h).
+//
+// Nel file di uscita: hTauBoot, hTauToy, hPullToy
+// =====================================================================
+
+// Istogramma dei valori finiti di v, con intervallo preso dai dati
+TH1F* BookToyHisto(const char* name, const char* title, const std::vector<double>& v, int nbins)
+{
+    double lo = 0.0, hi = 0.0;
+    bool first = true;
+    for (double x : v) {
+        if (std::isnan(x)) continue;
+        if (first || x < lo) lo = x;
+        if (first || x > hi) hi = x;
+        first = false;
+    }
+    double pad = (hi > lo) ? 0.05 * (hi - lo) : 1.0;
+
+    TH1F* h = new TH1F(name, title, nbins, lo - pad, hi + pad);
+    for (double x : v) {
+        if (!std::isnan(x)) h->Fill(x);
+    }
+    return h;
+}
+
+void Mu_life_toys(const char* filename = "FIFOread_Take5.txt",
+                  int nToys = 10000,
+                  int nBoot = 1000,
+                  double tmin = 0.0,
+                  double tmax = 20.0,
+                  int nThreads = 0,
+                  const char* calibFile = "ClockCalibration.txt")
+{
+    std::cout << "\n============================================\n";
+    std::cout << "[Mu_life_toys] File: " << filename << "\n";
+    std::cout << "[Mu_life_toys] Toy MC: " << nToys << ", bootstrap: " << nBoot << "\n";
+    std::cout << "============================================\n";
+
+    PairingParams params;
+    params.tmin = tmin;
+    params.tmax = tmax;
+    LoadCalibratedTick(calibFile, {filename}, params.tickUs);
+
+    TakeResult take;
+    if (!AnalyzeTake(filename, params, take, 1)) {
+        std::cerr << "[ERRORE] Impossibile aprire il file " << filename << "\n";
+        return;
+    }
+
+    LifetimeFitResult fit;
+    if (!FitLifetimeUnbinned(take.dt_values, tmin, tmax, fit)) {
+        std::cerr << "[ERRORE] Il fit unbinned non converge (" << take.dt_values.size()
+                  << " coppie).\n";
+        return;
+    }
+
+    std::cout << "[INFO] Coppie nella finestra: " << fit.nEvents << "\n";
+    std::cout << "[INFO] Fit unbinned: tau = " << fit.tau << " ± " << fit.tauErr
+              << " µs, fondo = " << fit.bkgFrac << " ± " << fit.bkgFracErr << "\n";
+
+    std::vector<double> t;
+    t.reserve(take.dt_values.size());
+    for (double x : take.dt_values) {
+        if (x >= tmin && x <= tmax) t.push_back(x);
+    }
+
+    unsigned int nt = (unsigned int)std::max(nThreads, 0);
+
+    ToyStudy boot;
+    BootstrapLifetime(t, tmin, tmax, fit, (std::size_t)std::max(nBoot, 0), boot, nt);
+
+    ToyStudy toys;
+    ToyMCLifetime(fit.tau, fit.bkgFrac, (double)fit.nEvents, tmin, tmax,
+                  (std::size_t)std::max(nToys, 0), toys, nt);
+
+    std::cout << "\n================ BOOTSTRAP ================\n";
+    std::cout << "Tau medio    = " << boot.mean << " µs  (bias " << boot.bias << ")\n";
+    std::cout << "Dispersione  = " << boot.rms  << " µs  (errore del fit " << fit.tauErr << ")\n";
+    std::cout << "Fit falliti  = " << boot.nFailed << " / " << boot.tau.size() << "\n";
+
+    std::cout << "\n================ TOY MC ================\n";
+    std::cout << "Tau medio    = " << toys.mean << " µs  (bias " << toys.bias << ")\n";
+    std::cout << "Dispersione  = " << toys.rms  << " µs\n";
+    std::cout << "Pull         = " << toys.pullMean << " ± " << toys.pullWidth << " (media, larghezza)\n";
+    std::cout << "Fit falliti  = " << toys.nFailed << " / " << toys.tau.size() << "\n";
+    std::cout << "==========================================\n";
+
+    TFile* fout = new TFile("Mu_life_toys.root", "RECREATE");
+    BookToyHisto("hTauBoot", "Bootstrap; #tau [#mu s]; Campioni", boot.tau, 100)->Write();
+    BookToyHisto("hTauToy", "Toy MC; #tau [#mu s]; Toy", toys.tau, 100)->Write();
+    BookToyHisto("hPullToy", "Toy MC; (#tau - #tau_{vero}) / #sigma_{#tau}; Toy", toys.pull, 100)->Write();
+    fout->Close();
+
+    std::cout << "[INFO] Risultati salvati in Mu_life_toys.root\n";
+}
+
+// =====================================================================
+//               MU_LIFE_SCAN (griglia di parametri)
+// =====================================================================
+//
+// Invece di cambiare EARLY_STOP_MAX_TICKS, FINAL_STOP_MAX_US,
+// EARLY/FINAL_BLOCK_WINDOW o [tmin, tmax] e rilanciare Mu_life_new,
+// prova tutte le combinazioni dei valori dati. Ogni lista è "v",
+// "v1,v2,…" oppure "inizio:fine:passo", ad es.
+//
+//   Mu_life_scan("data/Take", "5:15:1", "20", "2", "3", "0,0.75", "20")
+//
+// path è un file o una cartella (tutte le FIFOread_*.txt, coppie
+// sommate). I file sono letti una volta sola, pairing e fit dei punti
+// girano su nThreads core (0 = tutti, vedi ParameterScan.h). La tabella
+// di tau in funzione dei parametri è stampata e salvata in output (CSV).
+// =====================================================================
+
+void Mu_life_scan(const char* path = "data/Take",
+                  const char* early = "10",
+                  const char* finalUs = "20",
+                  const char* earlyBW = "2",
+                  const char* finalBW = "3",
+                  const char* tmin = "0",
+                  const char* tmax = "20",
+                  const char* output = "Mu_life_scan.csv",
+                  int nThreads = 0,
+                  const char* calibFile = "ClockCalibration.txt")
+{
+    ScanGrid grid;
+    if (!ParseScanList(early, grid.earlyStopMaxEvents) ||
+        !ParseScanList(finalUs, grid.finalStopMaxUs) ||
+        !ParseScanList(earlyBW, grid.earlyBlockWindow) ||
+        !ParseScanList(finalBW, grid.finalBlockWindow) ||
+        !ParseScanList(tmin, grid.tmin) ||
+        !ParseScanList(tmax, grid.tmax)) {
+        std::cerr << "[ERRORE] Lista di valori non valida (\"v\", \"v1,v2\" o \"inizio:fine:passo\").\n";
+        return;
+    }
+
+    std::error_code ec;
+    std::vector<std::string> files;
+    if (std::filesystem::is_directory(path, ec)) files = FindTakes(path);
+    else                                         files.push_back(path);
+
+    std::cout << "\n============================================\n";
+    std::cout << "[Mu_life_scan] " << path << " (" << files.size() << " file)\n";
+    std::cout << "[Mu_life_scan] Punti della griglia: " << grid.Size() << "\n";
+    std::cout << "============================================\n";
+
+    if (files.empty()) {
+        std::cerr << "[ERRORE] Nessun file FIFOread_*.txt in " << path << "\n";
+        return;
+    }
+
+    LoadCalibratedTick(calibFile, files, grid.tickUs);
+
+    std::vector<ScanPoint> points;
+    ScanInfo info;
+    if (!ScanLifetime(files, grid, points, (unsigned int)std::max(nThreads, 0), &info)) {
+        std::cerr << "[ERRORE] Impossibile aprire il file " << info.failed << "\n";
+        return;
+    }
+
+    std::cout << "[INFO] Righe lette: " << info.rows << ", eventi: " << info.events
+              << " (lettura " << info.readSec << " s, pairing e fit " << info.scanSec << " s)\n\n";
+    WriteScanTable(std::cout, points);
+
+    std::ofstream out(output);
+    WriteScanTable(out, points, true);
+    if (!out) {
+        std::cerr << "[ERRORE] Impossibile scrivere il file " << output << "\n";
+        return;
+    }
+    std::cout << "[INFO] Risultati salvati in " << output << "\n";
+}
+
+// =====================================================================
+//                 MU_LIFE_ONLINE (file che cresce)
+// =====================================================================
+//
+// Segue un file FIFOread_*.txt mentre il DAQ lo scrive: ogni pollMs ms
+// legge solo le righe nuove (OnlineAnalysis.h), riempie gli istogrammi
+// e aggiorna il canvas; ogni refitSec secondi, se ci sono coppie nuove,
+// rifà il fit unbinned su tutte le coppie raccolte e stampa tau. Si
+// ferma quando il file non cresce per idleStopSec secondi (0 = mai),
+// poi fa il fit finale come Mu_life_new e salva Mu_life_online.root.
+// =====================================================================
+
+void Mu_life_online(const char* filename = "FIFOread_Take5.txt",
+                    int nbins = 80,
+                    double tmin = 0.0,
+                    double tmax = 20.0,
+                    int refitSec = 60,
+                    int pollMs = 1000,
+                    int idleStopSec = 600,
+                    const char* calibFile = "ClockCalibration.txt")
+{
+    std::cout << "\n============================================\n";
+    std::cout << "[Mu_life_online] File: " << filename << "\n";
+    std::cout << "[Mu_life_online] Polling ogni " << pollMs << " ms, fit ogni "
+              << refitSec << " s, stop dopo " << idleStopSec << " s senza dati\n";
+    std::cout << "============================================\n";
+
+    PairingParams params;
+    params.tmin = tmin;
+    params.tmax = tmax;
+    LoadCalibratedTick(calibFile, {filename}, params.tickUs);
+
+    OnlinePairing online(params);
+    if (!online.Open(filename)) {
+        std::cerr << "[ERRORE] Impossibile aprire il file " << filename << "\n";
+        return;
+    }
+
+    DecayHistos h = BookDecayHistos(nbins, tmin, tmax);
+
+    TCanvas* c1 = new TCanvas("c1", "Muon lifetime (online)", 800, 600);
+    h.hDecay->Draw();
+
+    std::vector<double>       dt_values;
+    std::vector<unsigned int> stopBlocks;
+    std::vector<DecayPair>    pairs;
+
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point lastData  = Clock::now();
+    Clock::time_point lastRefit = Clock::now();
+    std::size_t       lastFitPairs = 0;
+
+    // Nuove coppie → istogrammi e lista dei dt per il fit
+    auto consume = [&]() {
+        std::vector<double>       dt;
+        std::vector<unsigned int> sb;
+        for (const DecayPair& p : pairs) {
+            dt.push_back((double)p.dtTicks * params.tickUs);
+            sb.push_back(p.stopBlocks);
+        }
+        FillDecayHistos(h, dt, sb);
+        dt_values.insert(dt_values.end(), dt.begin(), dt.end());
+        stopBlocks.insert(stopBlocks.end(), sb.begin(), sb.end());
+        pairs.clear();
+    };
+
+    for (;;) {
+        std::size_t rows = online.Poll(pairs);
+        Clock::time_point now = Clock::now();
+
+        if (rows > 0) {
+            lastData = now;
+            consume();
+            c1->Modified();
+            c1->Update();
+        }
+        gSystem->ProcessEvents();
+
+        if (online.Tail().Truncated()) {
+            std::cerr << "[ERRORE] Il file " << filename << " è stato troncato, mi fermo.\n";
+            break;
+        }
+
+        if (refitSec > 0 && now - lastRefit >= std::chrono::seconds(refitSec) &&
+            dt_values.size() != lastFitPairs) {
+            lastRefit = now;
+            lastFitPairs = dt_values.size();
+            LifetimeFitResult ml;
+            std::cout << "[ONLINE] righe " << online.Summary().rows
+                      << ", coppie " << dt_values.size();
+            if (FitLifetimeUnbinned(dt_values, tmin, tmax, ml)) {
+                std::cout << ", tau = " << ml.tau << " ± " << ml.tauErr << " µs"
+                          << ", fondo = " << ml.bkgFrac;
+            }
+            std::cout << std::endl;
+        }
+
+        if (idleStopSec > 0 && now - lastData >= std::chrono::seconds(idleStopSec)) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(std::max(pollMs, 1)));
+    }
+
+    online.Finish(pairs);
+    consume();
+
+    const PairingSummary& summary = online.Summary();
+    std::cout << "[INFO] Righe lette: " << summary.rows << "\n";
+    std::cout << "[INFO] Eventi dopo il primo reset: " << summary.events << "\n";
+    std::cout << "[INFO] Coppie START–STOP accettate: " << dt_values.size() << "\n";
+    if (online.Tail().BadLines() > 0) {
+        std::cout << "[ATTENZIONE] Righe non numeriche saltate: " << online.Tail().BadLines() << "\n";
+    }
+
+    if (dt_values.empty()) {
+        std::cerr << "[ATTENZIONE] Nessun dt ricostruito: controllare logica o parametri.\n";
+        return;
+    }
+
+    TF1* fExpBkg = FitDecay(h.hDecay, tmin, tmax);
+    std::cout << "\n================ RISULTATI FIT ================\n";
+    std::cout << "Tau (µ)  = " << fExpBkg->GetParameter(1) << " ± " << fExpBkg->GetParError(1) << " µs\n";
+    std::cout << "B (fondo)= " << fExpBkg->GetParameter(2) << " ± " << fExpBkg->GetParError(2) << " counts/bin\n";
+    std::cout << "==============================================\n";
+    c1->Modified();
+    c1->Update();
+
+    TFile* fout = new TFile("Mu_life_online.root", "RECREATE");
+    WriteDecayHistos(h);
+    fExpBkg->Write();
+    c1->Write();
+    fout->Close();
+
+    std::cout << "[INFO] Risultati salvati in Mu_life_online.root\n";
+}
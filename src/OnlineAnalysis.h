@@ -0,0 +1,204 @@
+#ifndef MULIFE_ONLINEANALYSIS_H
+#define MULIFE_ONLINEANALYSIS_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "FifoReader.h"
+#include "PairingEngine.h"
+
+// =====================================================================
+//            ANALISI ONLINE DI UN FILE FIFO CHE CRESCE
+// =====================================================================
+//
+// Durante la presa dati il DAQ aggiunge righe "CH CT" in fondo al file
+// FIFOread_*.txt. FifoTail ricorda fin dove ha letto e a ogni Poll
+// legge solo i byte nuovi (polling sulla dimensione del file, portabile
+// anche dove non c'è inotify). Una riga non ancora completa (senza
+// '\n' finale) resta in un piccolo buffer e viene completata al giro
+// successivo.
+//
+// OnlinePairing collega FifoTail a FifoDecoder e PairingEngine, che
+// tengono il loro stato tra una chiamata e l'altra (reset visti, START
+// in attesa, maschere dei blocchi): ogni Poll costa O(righe nuove) e le
+// coppie sono le stesse dell'analisi offline del file completo.
+// =====================================================================
+
+namespace mulife {
+
+class FifoTail {
+public:
+    bool Open(const char* path)
+    {
+        Close();
+        in_.open(path, std::ios::binary);
+        if (!in_) return false;
+        path_ = path;
+        return true;
+    }
+
+    void Close()
+    {
+        if (in_.is_open()) in_.close();
+        path_.clear();
+        offset_ = 0;
+        buf_.clear();
+        truncated_ = false;
+        badLines_ = 0;
+    }
+
+    // Accoda a CH e CT le righe complete aggiunte dall'ultima chiamata,
+    // leggendo al più maxBytes byte. Ritorna il numero di righe lette.
+    std::size_t Poll(std::vector<unsigned int>& CH, std::vector<unsigned int>& CT,
+                     std::size_t maxBytes = (std::size_t)1 << 22)
+    {
+        if (!in_.is_open()) return 0;
+
+        std::error_code ec;
+        std::uint64_t size = std::filesystem::file_size(path_, ec);
+        if (ec) return 0;
+        if (size < offset_) {
+            // il file è stato troncato o riscritto: non lo seguiamo più
+            truncated_ = true;
+            return 0;
+        }
+        if (size == offset_) return 0;
+
+        std::size_t n = (std::size_t)std::min<std::uint64_t>(size - offset_, maxBytes);
+        std::size_t carry = buf_.size();
+        buf_.resize(carry + n);
+
+        in_.clear();
+        in_.seekg((std::streamoff)offset_);
+        in_.read(buf_.data() + carry, (std::streamsize)n);
+        n = (std::size_t)in_.gcount();
+        buf_.resize(carry + n);
+        offset_ += n;
+
+        // solo fino all'ultimo '\n': il resto aspetta il prossimo giro
+        std::size_t complete = buf_.size();
+        while (complete > 0 && buf_[complete - 1] != '\n') --complete;
+        if (complete == 0) return 0;
+
+        std::size_t rows = ParseComplete(CH, CT, complete);
+        buf_.erase(buf_.begin(), buf_.begin() + (std::ptrdiff_t)complete);
+        return rows;
+    }
+
+    // Fine del file: anche l'ultima riga senza '\n' viene letta
+    std::size_t Flush(std::vector<unsigned int>& CH, std::vector<unsigned int>& CT)
+    {
+        buf_.push_back('\n');
+        std::size_t n = ParseComplete(CH, CT, buf_.size());
+        buf_.clear();
+        return n;
+    }
+
+    std::uint64_t Offset()    const { return offset_; }
+    bool          Truncated() const { return truncated_; }
+    std::size_t   BadLines()  const { return badLines_; }
+
+private:
+    // Parsing dei primi complete byte del buffer (righe intere)
+    std::size_t ParseComplete(std::vector<unsigned int>& CH, std::vector<unsigned int>& CT,
+                              std::size_t complete)
+    {
+        const std::size_t before = CH.size();
+        const char* p   = buf_.data();
+        const char* end = buf_.data() + complete;
+        while (p < end) {
+            p = ParseFifoText(p, end, CH, CT);
+            if (p < end) {
+                // riga non numerica: la saltiamo
+                const char* nl = static_cast<const char*>(std::memchr(p, '\n', (std::size_t)(end - p)));
+                p = (nl != nullptr) ? nl + 1 : end;
+                ++badLines_;
+            }
+        }
+        return CH.size() - before;
+    }
+
+    std::string       path_;
+    std::ifstream     in_;
+    std::uint64_t     offset_    = 0;       // byte già letti dal file
+    std::vector<char> buf_;                 // riga incompleta + byte nuovi
+    bool              truncated_ = false;
+    std::size_t       badLines_  = 0;
+};
+
+class OnlinePairing {
+public:
+    explicit OnlinePairing(const PairingParams& params = PairingParams())
+        : engine_(params) {}
+
+    bool Open(const char* path) { return tail_.Open(path); }
+
+    // Legge, decodifica e accoppia tutte le righe nuove; accoda in out
+    // le coppie completate. Ritorna il numero di righe nuove.
+    std::size_t Poll(std::vector<DecayPair>& out)
+    {
+        std::size_t rows = 0;
+        for (;;) {
+            CH_.clear();
+            CT_.clear();
+            std::size_t n = tail_.Poll(CH_, CT_);
+            if (n == 0) break;
+            rows += n;
+
+            events_.clear();
+            decoder_.Decode(CH_.data(), CT_.data(), n, events_);
+
+            std::size_t before = out.size();
+            engine_.Process(events_, out);
+            summary_.pairs += out.size() - before;
+        }
+        summary_.rows     = decoder_.Rows();
+        summary_.events   = engine_.Events();
+        summary_.counters = engine_.Counters();
+        return rows;
+    }
+
+    // Fine della presa dati: ultima riga incompleta e maschere ancora aperte
+    void Finish(std::vector<DecayPair>& out)
+    {
+        Poll(out);
+
+        std::size_t before = out.size();
+        CH_.clear();
+        CT_.clear();
+        std::size_t n = tail_.Flush(CH_, CT_);
+        events_.clear();
+        decoder_.Decode(CH_.data(), CT_.data(), n, events_);
+        engine_.Process(events_, out);
+        engine_.Finish(out);
+
+        summary_.rows     = decoder_.Rows();
+        summary_.events   = engine_.Events();
+        summary_.counters = engine_.Counters();
+        summary_.pairs += out.size() - before;
+    }
+
+    const PairingSummary& Summary() const { return summary_; }
+    const FifoTail&       Tail()    const { return tail_; }
+
+private:
+    FifoTail      tail_;
+    FifoDecoder   decoder_;
+    PairingEngine engine_;
+
+    std::vector<unsigned int> CH_;
+    std::vector<unsigned int> CT_;
+    EventStore                events_;
+    PairingSummary            summary_;
+};
+
+} // namespace mulife
+
+#endif // MULIFE_ONLINEANALYSIS_H
@@ -0,0 +1,636 @@
+#ifndef MULIFE_PAIRINGENGINE_H
+#define MULIFE_PAIRINGENGINE_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "EventBitmaps.h"
+#include "FifoBinary.h"
+#include "MuDecoding.h"
+
+// =====================================================================
+//                 PAIRING START → STOP IN STREAMING
+// =====================================================================
+//
+// Stessa logica del loop principale di Mu_life_new, ma gli eventi sono
+// consumati uno alla volta (a blocchi) invece che da un vettore con
+// l'intero file:
+//
+//   START → stop "immediato" entro earlyStopMaxEvents eventi
+//         → STOP finale (bit1) entro finalStopMaxUs dallo start
+//
+// Un nuovo START in mezzo sostituisce quello vecchio; uno start senza
+// stop viene scartato e l'evento che ha chiuso la ricerca viene
+// riconsiderato come possibile START.
+//
+// Gli eventi arrivano a blocchi in forma di EventStore. Per ogni blocco
+// si costruiscono prima le bitmap dei candidati (EventBitmaps.h): lo
+// stato Idle salta al prossimo START e gli stati di attesa al prossimo
+// candidato con NextSetBit, senza un branch per evento; nel caso normale
+// (ogni evento è START o stop) le serie di START sono indipendenti e si
+// accoppiano direttamente scorrendo i bit (PairRuns). CollectBlockMask
+// (OR dei bit dei blocchi su ±halfWindow eventi) legge direttamente gli
+// array del blocco; ai bordi la parte "all'indietro" viene da una piccola
+// coda con gli ultimi eventi del blocco precedente e la parte "in
+// avanti" viene completata con i primi eventi del blocco successivo.
+// Una coppia viene resa solo quando entrambe le maschere sono complete,
+// quindi la memoria è costante e indipendente dalla lunghezza della
+// presa dati.
+//
+// L'engine è un template sul layout dei canali (MuDecoding.h):
+// PairingEngine è la versione per Mu5Layout. Le maschere dei blocchi
+// delle coppie escono sempre come BIT_B8 … BIT_B11.
+//
+// Tutti i tempi sono in tick interi: finalStopMaxUs, tmin e tmax sono
+// convertiti una volta sola nel costruttore e il dt della coppia resta
+// in tick (DecayPair::dtTicks) fino al riempimento degli istogrammi.
+//
+// Ogni START ha un solo esito, contato in PairingCounters: coppia
+// accettata oppure uno dei motivi di scarto. I contatori si aggiornano
+// solo nei rami già presenti (nessun lavoro in più per evento); gli
+// START in mezzo a una serie, che la macchina a stati salta, sono
+// contati a blocchi dalle bitmap (popcount).
+// =====================================================================
+
+namespace mulife {
+
+// Parametri logici di default
+const int    EARLY_STOP_MAX_TICKS = 10;     // stop "immediato" entro 10 eventi dopo lo start
+const double FINAL_STOP_MAX_US    = 20.0;   // stop fisico entro 20 µs dallo start
+const int    EARLY_BLOCK_WINDOW   = 2;      // ±2 eventi per stimare i blocchi dello stop "immediato"
+const int    FINAL_BLOCK_WINDOW   = 3;      // ±3 eventi per stimare i blocchi dello stop finale
+
+struct PairingParams {
+    int    earlyStopMaxEvents = EARLY_STOP_MAX_TICKS;
+    double finalStopMaxUs     = FINAL_STOP_MAX_US;
+    int    earlyBlockWindow   = EARLY_BLOCK_WINDOW;
+    int    finalBlockWindow   = FINAL_BLOCK_WINDOW;
+    double tmin               = 0.0;    // finestra accettata per dt [µs]
+    double tmax               = 20.0;
+    double tickUs             = tick_us;   // durata di un tick del contatore [µs]
+};
+
+// Esito di ogni START (la somma dei campi dopo starts è uguale a starts)
+struct PairingCounters {
+    std::size_t starts          = 0;   // eventi START
+    std::size_t newStartEarly   = 0;   // nuovo START in attesa dello stop "immediato"
+    std::size_t noEarlyStop     = 0;   // nessuno stop entro earlyStopMaxEvents eventi
+    std::size_t newStartFinal   = 0;   // nuovo START in attesa dello STOP finale
+    std::size_t noFinalStop     = 0;   // nessuno STOP entro finalStopMaxUs
+    std::size_t outOfWindow     = 0;   // dt fuori da [tmin, tmax]
+    std::size_t accepted        = 0;   // coppie accettate
+    std::size_t unfinished      = 0;   // START ancora aperto a fine flusso
+
+    void Add(const PairingCounters& o)
+    {
+        starts        += o.starts;
+        newStartEarly += o.newStartEarly;
+        noEarlyStop   += o.noEarlyStop;
+        newStartFinal += o.newStartFinal;
+        noFinalStop   += o.noFinalStop;
+        outOfWindow   += o.outOfWindow;
+        accepted      += o.accepted;
+        unfinished    += o.unfinished;
+    }
+};
+
+struct DecayPair {
+    long long    dtTicks;       // tempo di decadimento [tick]
+    unsigned int startBlocks;   // blocchi attorno allo stop "immediato"
+    unsigned int stopBlocks;    // blocchi attorno allo stop finale
+    std::size_t  startRow;      // righe del file di START e STOP finale
+    std::size_t  stopRow;
+};
+
+template <class Layout>
+class BasicPairingEngine {
+public:
+    static constexpr unsigned int BLOCKS = Layout::BLOCK_MASK;
+
+    explicit BasicPairingEngine(const PairingParams& params = PairingParams())
+        : params_(params),
+          finalMaxTicks_(FloorTicks(params.finalStopMaxUs, params.tickUs)),
+          tminTicks_(CeilTicks(params.tmin, params.tickUs)),
+          tmaxTicks_(FloorTicks(params.tmax, params.tickUs)),
+          window_((std::size_t)std::max(std::max(params.earlyBlockWindow,
+                                                 params.finalBlockWindow), 0)) {}
+
+    // Consuma un blocco di eventi e accoda in out le coppie completate
+    void Process(const EventStore& ev, std::vector<DecayPair>& out)
+    {
+        const std::size_t n = ev.size();
+        if (n == 0) return;
+
+        // metà "in avanti" delle maschere rimaste aperte dal blocco prima
+        if (earlyLeft_ > 0) earlyMask_ |= ForwardMask(ev, 0, earlyLeft_);
+        for (Pending& p : pending_) {
+            if (p.earlyLeft > 0) p.pair.startBlocks |= ForwardMask(ev, 0, p.earlyLeft);
+            if (p.finalLeft > 0) p.pair.stopBlocks  |= ForwardMask(ev, 0, p.finalLeft);
+        }
+        Emit(out);
+
+        // pre-passaggio: bitmap dei candidati START / STOP del blocco
+        BuildEventBitmaps<Layout>(ev.ch.data(), n, bits_);
+        CountStarts(ev);
+        const std::uint64_t* startBits = bits_.start.data();
+        // con earlyStopMaxEvents >= 1 uno START seguito da un altro START
+        // finisce sempre in newStartEarly e si salta (contato in
+        // CountStarts); con 0 nessuno stop è ammesso e ogni START della
+        // serie va nella macchina a stati (noEarlyStop)
+        const std::uint64_t* runEnd    = SkipRuns() ? bits_.runEnd.data() : startBits;
+        const std::uint64_t* earlyBits = bits_.earlyCand.data();
+        const std::uint64_t* finalBits = bits_.finalCand.data();
+        const long long*     ticks     = ev.ticks.data();
+
+        // serie di START indipendenti (vedi PairRuns)
+        const bool runsIndependent = bits_.allEarly && SkipRuns();
+
+        // stato della macchina in variabili locali per tutto il blocco
+        State        state      = state_;
+        long long    tStart     = tStart_;
+        std::size_t  startRow   = startRow_;
+        int          sinceStart = sinceStart_;
+        unsigned int earlyMask  = earlyMask_;
+        int          earlyLeft  = earlyLeft_;
+
+        // indice dello START nel blocco; NO_ROW se lo START è in un blocco
+        // precedente (la sua riga è allora già in startRow)
+        std::size_t startIdx = NO_ROW;
+
+        // indice dello stop "immediato" nel blocco: la sua maschera serve
+        // solo se la coppia viene accettata e si calcola solo allora (o a
+        // fine blocco, se l'attesa dello stop finale continua nel prossimo)
+        std::size_t earlyIdx = NO_ROW;
+
+        std::size_t i = 0;
+        while (i < n) {
+            if (state == State::Idle) {
+                if (runsIndependent) i = PairRuns(ev, i, out);
+                // salta direttamente al prossimo START (l'ultimo della serie)
+                i = NextSetBit(runEnd, i, n);
+                if (i == n) break;
+                state = State::WaitEarly;
+                startIdx = i;
+                tStart = ticks[i];
+                sinceStart = 0;
+                earlyLeft = 0;
+                ++i;
+            }
+
+            if (state == State::WaitEarly) {
+                // primo START o stop generico tra gli eventi ancora ammessi
+                const std::size_t allowed = (std::size_t)std::max(params_.earlyStopMaxEvents - sinceStart, 0);
+                const std::size_t limit   = std::min(n, i + allowed);
+                const std::size_t j       = NextSetBit(earlyBits, i, limit);
+                if (j == limit) {
+                    if (limit < n) {
+                        // nessun stop immediato → scarta lo start e riconsidera l'evento
+                        Count(counters_.noEarlyStop, RowOf(ev, startIdx, startRow));
+                        state = State::Idle;
+                    } else {
+                        sinceStart += (int)(limit - i);
+                    }
+                    i = limit;
+                    continue;
+                }
+                // Se nel mezzo appare un nuovo START → scartiamo quello vecchio
+                if (TestBit(startBits, j)) {
+                    Count(counters_.newStartEarly, RowOf(ev, startIdx, startRow));
+                    i = NextSetBit(runEnd, j, n);
+                    startIdx = i;
+                    tStart = ticks[i];
+                    sinceStart = 0;
+                    ++i;
+                    continue;
+                }
+                // stop generico: almeno un bit tra 2,4,8,16,32
+                earlyIdx = j;
+                state = State::WaitFinal;
+                i = j + 1;
+                continue;
+            }
+
+            // State::WaitFinal: prossimo START o STOP finale; la finestra in
+            // tempo va controllata su tutti gli eventi fino a lui compreso
+            const std::size_t j = NextSetBit(finalBits, i, n);
+            const std::size_t k = FirstLate(ticks, i, j, n, tStart);
+            if (k != NO_ROW) {
+                // oltre la finestra → stop non trovato, riconsidera l'evento
+                Count(counters_.noFinalStop, RowOf(ev, startIdx, startRow));
+                state = State::Idle;
+                i = k;
+                continue;
+            }
+            if (j == n) break;
+
+            // se appare un nuovo START prima dello stop finale → scartiamo
+            if (TestBit(startBits, j)) {
+                Count(counters_.newStartFinal, RowOf(ev, startIdx, startRow));
+                state = State::WaitEarly;
+                i = NextSetBit(runEnd, j, n);
+                startIdx = i;
+                tStart = ticks[i];
+                sinceStart = 0;
+                earlyLeft = 0;
+                ++i;
+                continue;
+            }
+
+            // STOP finale: richiediamo il bit1 (STOP generale)
+            const long long dt = ticks[j] - tStart;
+            const std::size_t row = RowOf(ev, startIdx, startRow);
+            if (dt >= tminTicks_ && dt <= tmaxTicks_) {
+                if (earlyIdx != NO_ROW) {
+                    earlyLeft = params_.earlyBlockWindow;
+                    earlyMask = CollectBlockMask(ev, earlyIdx, earlyLeft);
+                }
+                Count(counters_.accepted, row);
+                EmitPair(ev, row, earlyMask, earlyLeft, j, dt, out);
+            } else {
+                Count(counters_.outOfWindow, row);
+            }
+            earlyLeft = 0;
+            state = State::Idle;
+            i = j + 1;
+        }
+
+        if (startIdx != NO_ROW) startRow = ev.row[startIdx];
+        if (state == State::WaitFinal && earlyIdx != NO_ROW) {
+            earlyLeft = params_.earlyBlockWindow;
+            earlyMask = CollectBlockMask(ev, earlyIdx, earlyLeft);
+        }
+
+        state_      = state;
+        tStart_     = tStart;
+        startRow_   = startRow;
+        sinceStart_ = sinceStart;
+        earlyMask_  = earlyMask;
+        earlyLeft_  = earlyLeft;
+
+        // coda del blocco: servirà alla metà "all'indietro" del prossimo
+        const std::size_t keep = std::min(n, window_);
+        for (std::size_t k = n - keep; k < n; ++k) PushTail(ev.ch[k]);
+        nEvents_ += n;
+    }
+
+    // Fine del flusso: le maschere ancora aperte restano troncate
+    // (come CollectBlockMask in fondo al vettore) e lo start in corso
+    // viene scartato.
+    void Finish(std::vector<DecayPair>& out)
+    {
+        for (Pending& p : pending_) {
+            p.earlyLeft = 0;
+            p.finalLeft = 0;
+        }
+        Emit(out);
+        if (state_ != State::Idle) Count(counters_.unfinished, startRow_);
+        state_ = State::Idle;
+        earlyLeft_ = 0;
+    }
+
+    // Inserisce nella coda un evento che precede il flusso (per chi
+    // riparte a metà file), senza far avanzare la macchina a stati
+    void Seed(unsigned int ch) { PushTail(ch); }
+
+    // Riga dello START più vecchio non ancora risolto (in corso o in
+    // attesa delle maschere), oppure NO_ROW se non ce ne sono
+    static constexpr std::size_t NO_ROW = (std::size_t)-1;
+
+    std::size_t OpenStartRow() const
+    {
+        if (!pending_.empty()) return pending_.front().pair.startRow;
+        return (state_ == State::Idle) ? NO_ROW : startRow_;
+    }
+
+    std::size_t Events() const { return nEvents_; }
+
+    // Esiti degli START visti finora
+    const PairingCounters& Counters() const { return counters_; }
+
+    // Conta solo gli START nelle righe < row (per chi, come il pairing
+    // parallelo, prosegue oltre il proprio blocco)
+    void SetCountLimit(std::size_t row) { countLimit_ = row; }
+
+private:
+    enum class State { Idle, WaitEarly, WaitFinal };
+
+    struct Pending {
+        DecayPair    pair;
+        int          earlyLeft;   // eventi del prossimo blocco da OR-are nella maschera early
+        int          finalLeft;   // idem per la maschera dello stop finale
+    };
+
+    // OR dei bit dei blocchi (8,9,10,11) sugli eventi [center - halfWindow,
+    // center + halfWindow]. La parte prima del blocco viene dalla coda del
+    // blocco precedente; in left resta il numero di eventi successivi che
+    // cadono nel prossimo blocco.
+    unsigned int CollectBlockMask(const EventStore& ev, std::size_t center, int& left) const
+    {
+        const std::size_t hw = (std::size_t)std::max(left, 0);
+        const unsigned int* ch = ev.ch.data();
+        unsigned int mask = 0u;
+
+        // caso comune: la finestra è tutta dentro il blocco
+        if (center >= hw && center + hw < ev.size()) {
+            for (std::size_t k = center - hw; k <= center + hw; ++k) mask |= ch[k];
+            left = 0;
+            return mask & BLOCKS;
+        }
+
+        std::size_t iMin = (center >= hw) ? center - hw : 0;
+        for (std::size_t k = iMin; k <= center; ++k) mask |= ch[k] & BLOCKS;
+
+        // eventi mancanti all'indietro: dalla coda, per quanto disponibile
+        std::size_t missing = hw - (center - iMin);
+        for (std::size_t k = 0; k < missing && k < tail_.size(); ++k) {
+            mask |= tail_[tail_.size() - 1 - k];
+        }
+
+        const std::size_t n = ev.size();
+        std::size_t iMax = std::min(n - 1, center + hw);
+        for (std::size_t k = center + 1; k <= iMax; ++k) mask |= ch[k] & BLOCKS;
+
+        left = (int)(hw - (iMax - center));
+        return mask;
+    }
+
+    void Count(std::size_t& counter, std::size_t startRow) const
+    {
+        if (startRow < countLimit_) ++counter;
+    }
+
+    static std::size_t RowOf(const EventStore& ev, std::size_t startIdx, std::size_t startRow)
+    {
+        return (startIdx != NO_ROW) ? ev.row[startIdx] : startRow;
+    }
+
+    // Le serie di START consecutivi si saltano fino all'ultimo solo se
+    // il primo evento dopo uno START può esserne lo stop "immediato"
+    bool SkipRuns() const { return params_.earlyStopMaxEvents >= 1; }
+
+    // START del blocco (entro il limite di conteggio) e, tra questi,
+    // quelli seguiti subito da un altro START: con SkipRuns() la macchina
+    // a stati li salta e sono sostituiti dal nuovo START prima di ogni
+    // altra cosa
+    void CountStarts(const EventStore& ev)
+    {
+        const std::size_t n = (ev.row.back() < countLimit_)
+            ? ev.size()
+            : (std::size_t)(std::lower_bound(ev.row.begin(), ev.row.end(), countLimit_) - ev.row.begin());
+        const std::size_t full = n / 64;
+        std::size_t starts = 0, inRun = 0;
+        for (std::size_t w = 0; w <= full && w < bits_.start.size(); ++w) {
+            std::uint64_t valid = (w < full) ? ~(std::uint64_t)0 : ((std::uint64_t)1 << (n % 64)) - 1;
+            std::uint64_t s = bits_.start[w] & valid;
+            starts += (std::size_t)detail::PopCount64(s);
+            inRun  += (std::size_t)detail::PopCount64(s & ~bits_.runEnd[w]);
+        }
+        counters_.starts += starts;
+        if (SkipRuns()) counters_.newStartEarly += inRun;
+    }
+
+    // Primo evento in [from, j] (j = n: fino alla fine del blocco) oltre
+    // la finestra dello stop finale, oppure NO_ROW
+    std::size_t FirstLate(const long long* ticks, std::size_t from, std::size_t j,
+                          std::size_t n, long long tStart) const
+    {
+        const std::size_t last = (j < n) ? j : n - 1;
+        for (std::size_t k = from; k <= last; ++k) {
+            if (ticks[k] - tStart > finalMaxTicks_) return k;
+        }
+        return NO_ROW;
+    }
+
+    // Coppia accettata: maschera dello stop finale e uscita (subito se
+    // nessuna maschera resta aperta, altrimenti in coda)
+    void EmitPair(const EventStore& ev, std::size_t startRow, unsigned int earlyMask,
+                  int earlyLeft, std::size_t stopIdx, long long dt,
+                  std::vector<DecayPair>& out)
+    {
+        Pending p;
+        p.pair.dtTicks     = dt;
+        p.pair.startBlocks = earlyMask;
+        p.pair.startRow    = startRow;
+        p.pair.stopRow     = ev.row[stopIdx];
+        p.earlyLeft        = earlyLeft;
+        p.finalLeft        = params_.finalBlockWindow;
+        p.pair.stopBlocks  = CollectBlockMask(ev, stopIdx, p.finalLeft);
+        if (pending_.empty() && p.earlyLeft == 0 && p.finalLeft == 0) {
+            Output(p.pair, out);
+        } else {
+            pending_.push_back(p);
+        }
+    }
+
+    // Pairing nello stato Idle a partire da from, quando ogni evento è uno
+    // START o uno stop generico (come dopo FifoDecoder) e
+    // earlyStopMaxEvents >= 1. Allora per l'ultimo START L di una serie lo
+    // stop "immediato" è sempre L+1, e qualunque cosa chiuda l'attesa dello
+    // stop finale (stop, nuovo START, fine finestra) non ci sono START
+    // prima di lei: la ricerca riprende dalla serie successiva. Le serie
+    // sono quindi indipendenti e si scorrono con un ciclo sui bit di
+    // runEnd, senza catena di dipendenze tra una e l'altra.
+    // Ritorna l'indice del primo START che non si chiude nel blocco
+    // (da passare alla macchina a stati), oppure n.
+    std::size_t PairRuns(const EventStore& ev, std::size_t from, std::vector<DecayPair>& out)
+    {
+        const std::size_t    n         = ev.size();
+        const std::uint64_t* runEnd    = bits_.runEnd.data();
+        const std::uint64_t* startBits = bits_.start.data();
+        const std::uint64_t* finalBits = bits_.finalCand.data();
+        const long long*     ticks     = ev.ticks.data();
+        const std::size_t    words     = bits_.runEnd.size();
+
+        for (std::size_t w = from / 64; w < words; ++w) {
+            std::uint64_t word = runEnd[w];
+            if (w == from / 64) word &= ~(std::uint64_t)0 << (from % 64);
+            for (; word != 0u; word &= word - 1) {
+                const std::size_t L = 64 * w + (std::size_t)detail::CountTrailingZeros64(word);
+                if (L + 1 >= n) return L;
+
+                const long long   tStart = ticks[L];
+                const std::size_t j = NextSetBit(finalBits, L + 2, n);
+                if (FirstLate(ticks, L + 2, j, n, tStart) != NO_ROW) {
+                    Count(counters_.noFinalStop, ev.row[L]);
+                    continue;
+                }
+                if (j == n) return L;
+                if (TestBit(startBits, j)) {
+                    Count(counters_.newStartFinal, ev.row[L]);
+                    continue;
+                }
+
+                const long long dt = ticks[j] - tStart;
+                if (dt >= tminTicks_ && dt <= tmaxTicks_) {
+                    int left = params_.earlyBlockWindow;
+                    unsigned int mask = CollectBlockMask(ev, L + 1, left);
+                    Count(counters_.accepted, ev.row[L]);
+                    EmitPair(ev, ev.row[L], mask, left, j, dt, out);
+                } else {
+                    Count(counters_.outOfWindow, ev.row[L]);
+                }
+            }
+        }
+        return n;
+    }
+
+    // OR dei primi min(left, n) eventi del blocco; aggiorna left
+    static unsigned int ForwardMask(const EventStore& ev, std::size_t from, int& left)
+    {
+        std::size_t m = std::min(ev.size() - from, (std::size_t)left);
+        unsigned int mask = 0u;
+        for (std::size_t k = from; k < from + m; ++k) mask |= ev.ch[k] & BLOCKS;
+        left -= (int)m;
+        return mask;
+    }
+
+    void PushTail(unsigned int ch)
+    {
+        if (window_ == 0) return;
+        if (tail_.size() == window_) tail_.erase(tail_.begin());
+        tail_.push_back(ch & BLOCKS);
+    }
+
+    void Emit(std::vector<DecayPair>& out)
+    {
+        while (!pending_.empty() &&
+               pending_.front().earlyLeft == 0 && pending_.front().finalLeft == 0) {
+            Output(pending_.front().pair, out);
+            pending_.pop_front();
+        }
+    }
+
+    // Uscita di una coppia completa, con le maschere in BIT_B8 … BIT_B11
+    static void Output(DecayPair p, std::vector<DecayPair>& out)
+    {
+        p.startBlocks = Layout::CanonicalBlocks(p.startBlocks);
+        p.stopBlocks  = Layout::CanonicalBlocks(p.stopBlocks);
+        out.push_back(p);
+    }
+
+    PairingParams params_;
+
+    // finestre in tick, precalcolate dai parametri in µs
+    long long finalMaxTicks_;
+    long long tminTicks_;
+    long long tmaxTicks_;
+
+    EventBitmaps bits_;      // bitmap del blocco corrente, riusate
+
+    // bit dei blocchi degli ultimi window_ eventi visti (dal più vecchio)
+    std::size_t               window_;
+    std::vector<unsigned int> tail_;
+    std::size_t               nEvents_ = 0;
+
+    PairingCounters counters_;
+    std::size_t     countLimit_ = NO_ROW;
+
+    State        state_      = State::Idle;
+    long long    tStart_     = 0;
+    std::size_t  startRow_   = 0;
+    int          sinceStart_ = 0;
+    unsigned int earlyMask_  = 0u;
+    int          earlyLeft_  = 0;
+
+    std::deque<Pending> pending_;
+};
+
+using PairingEngine = BasicPairingEngine<Mu5Layout>;
+
+// Tempo di lavoro per stadio [s]. Con più worker (pairing parallelo)
+// è la somma sui thread, non il tempo trascorso.
+struct StageTimes {
+    double read   = 0.0;   // lettura / parsing delle righe
+    double decode = 0.0;   // righe → eventi con tempo assoluto
+    double pair   = 0.0;   // macchina a stati START → STOP
+    double sink   = 0.0;   // consumo delle coppie (istogrammi, ...)
+};
+
+// Riepilogo di un passaggio completo su un file
+struct PairingSummary {
+    std::size_t     rows   = 0;    // righe lette
+    std::size_t     events = 0;    // eventi utili dopo il primo reset
+    std::size_t     pairs  = 0;    // coppie START–STOP accettate
+    PairingCounters counters;      // esito di ogni START
+    StageTimes      times;
+};
+
+namespace detail {
+
+using StageClock = std::chrono::steady_clock;
+
+// Secondi da t0; t0 passa all'istante attuale
+inline double SecondsSince(StageClock::time_point& t0)
+{
+    StageClock::time_point t1 = StageClock::now();
+    double s = std::chrono::duration<double>(t1 - t0).count();
+    t0 = t1;
+    return s;
+}
+
+} // namespace detail
+
+// Lettura, decodifica e pairing di un file a blocchi di chunkRows righe.
+// sink(const DecayPair&) viene chiamato per ogni coppia, in ordine.
+// Ritorna false se il file non può essere aperto.
+// Layout sceglie la mappa dei canali, ad es. StreamPairs<DecayTimeLayout>(...).
+template <class Layout = Mu5Layout, class Sink>
+bool StreamPairs(const char* path, const PairingParams& params, Sink&& sink,
+                 PairingSummary* summary = nullptr,
+                 std::size_t chunkRows = (std::size_t)1 << 16)
+{
+    FifoStream in;
+    if (!in.Open(path)) return false;
+
+    BasicFifoDecoder<Layout>   decoder;
+    BasicPairingEngine<Layout> engine(params);
+    PairingSummary s;
+
+    std::vector<unsigned int> CH;
+    std::vector<unsigned int> CT;
+    EventStore                events;
+    std::vector<DecayPair>    pairs;
+    CH.reserve(chunkRows);
+    CT.reserve(chunkRows);
+    events.reserve(chunkRows);
+
+    // un orologio per blocco e per stadio: costo trascurabile su 64k righe
+    detail::StageClock::time_point t0 = detail::StageClock::now();
+    while (in.Next(CH, CT, chunkRows) > 0) {
+        s.times.read += detail::SecondsSince(t0);
+
+        events.clear();
+        decoder.Decode(CH.data(), CT.data(), CH.size(), events);
+        s.times.decode += detail::SecondsSince(t0);
+
+        pairs.clear();
+        engine.Process(events, pairs);
+        s.times.pair += detail::SecondsSince(t0);
+
+        for (const DecayPair& p : pairs) sink(p);
+        s.pairs += pairs.size();
+        s.times.sink += detail::SecondsSince(t0);
+    }
+    s.times.read += detail::SecondsSince(t0);
+
+    pairs.clear();
+    engine.Finish(pairs);
+    s.times.pair += detail::SecondsSince(t0);
+    for (const DecayPair& p : pairs) sink(p);
+    s.pairs += pairs.size();
+    s.times.sink += detail::SecondsSince(t0);
+
+    s.rows     = decoder.Rows();
+    s.events   = engine.Events();
+    s.counters = engine.Counters();
+    if (summary != nullptr) *summary = s;
+    return true;
+}
+
+} // namespace mulife
+
+#endif // MULIFE_PAIRINGENGINE_H
@@ -0,0 +1,57 @@
+#ifndef MULIFE_PARALLEL_H
+#define MULIFE_PARALLEL_H
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// =====================================================================
+//                 ESECUZIONE PARALLELA DI TASK INDIPENDENTI
+// =====================================================================
+//
+// ParallelFor(nTasks, nThreads, fn) chiama fn(task, thread) per ogni
+// task in [0, nTasks), distribuendo i task su nThreads thread che se li
+// prendono da un contatore atomico (i task lunghi non bloccano gli
+// altri). Con nThreads <= 1 tutto gira nel thread chiamante.
+// =====================================================================
+
+namespace mulife {
+
+// Numero di thread di default: quelli della macchina
+inline unsigned int DefaultThreads()
+{
+    unsigned int n = std::thread::hardware_concurrency();
+    return (n > 0) ? n : 1;
+}
+
+template <class Fn>
+void ParallelFor(std::size_t nTasks, unsigned int nThreads, Fn&& fn)
+{
+    if (nThreads == 0) nThreads = DefaultThreads();
+    if (nThreads > nTasks) nThreads = (unsigned int)nTasks;
+
+    if (nThreads <= 1) {
+        for (std::size_t t = 0; t < nTasks; ++t) fn(t, 0u);
+        return;
+    }
+
+    std::atomic<std::size_t> next(0);
+    auto worker = [&](unsigned int thread) {
+        for (;;) {
+            std::size_t t = next.fetch_add(1);
+            if (t >= nTasks) return;
+            fn(t, thread);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(nThreads - 1);
+    for (unsigned int k = 1; k < nThreads; ++k) pool.emplace_back(worker, k);
+    worker(0u);
+    for (std::thread& th : pool) th.join();
+}
+
+} // namespace mulife
+
+#endif // MULIFE_PARALLEL_H
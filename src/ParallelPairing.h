@@ -0,0 +1,218 @@
+#ifndef MULIFE_PARALLELPAIRING_H
+#define MULIFE_PARALLELPAIRING_H
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "Parallel.h"
+#include "PairingEngine.h"
+
+// =====================================================================
+//              PAIRING PARALLELO SU SEGMENTI TRA I RESET
+// =====================================================================
+//
+// Le parole di reset dividono la presa dati in segmenti indipendenti
+// per quanto riguarda il tempo: il segmento che segue il k-esimo reset
+// ha offset (k-1)*reset_t_us. Il file viene diviso in nTasks blocchi,
+// ciascuno che inizia sul primo START dopo un reset; ogni blocco è
+// decodificato e accoppiato da un worker separato.
+//
+// Cucitura ai bordi: qualunque sia lo stato della macchina a stati,
+// un evento START la riporta sempre nello stesso stato (nuovo start).
+// Quindi dal primo START del blocco successivo in poi il worker
+// precedente e quello successivo producono le stesse coppie. Ogni
+// worker:
+//   - riempie la coda dell'engine con gli eventi che precedono il suo inizio
+//     (per le finestre ±EARLY/FINAL_BLOCK_WINDOW a cavallo del bordo);
+//   - prosegue oltre la sua fine finché le coppie con START prima del
+//     bordo (compresi stop finali e maschere nel blocco dopo) non sono
+//     chiuse;
+//   - tiene solo le coppie con START prima del bordo.
+// Il risultato è identico, coppia per coppia, al pairing sequenziale.
+// =====================================================================
+
+namespace mulife {
+
+namespace detail {
+
+// Blocchi per thread: al più TASKS_PER_THREAD * nThreads in tutto
+const std::size_t TASKS_PER_THREAD = 4;
+
+template <class Layout>
+inline bool IsUsefulWord(unsigned int ch)
+{
+    return !Layout::IsReset(ch) && Layout::Keep(ch);
+}
+
+// Prima riga >= row che sia uno START preceduto (nel segmento) da un reset
+template <class Layout>
+inline std::size_t NextStartAfterReset(const std::vector<unsigned int>& CH, std::size_t row)
+{
+    const std::size_t N = CH.size();
+    while (row < N && !Layout::IsReset(CH[row])) ++row;
+    while (row < N && (Layout::IsReset(CH[row]) || (CH[row] & Layout::START) == 0u)) ++row;
+    return row;
+}
+
+} // namespace detail
+
+// Pairing di un file già in memoria con nThreads worker (0 = tutti i
+// core). sink(const DecayPair&, task, thread) è chiamato direttamente
+// dai worker per ogni coppia accettata: in ordine dentro un blocco
+// (task), in ordine qualunque tra blocchi diversi. Due chiamate con lo
+// stesso thread non sono mai concorrenti.
+// Con un layout senza reset non ci sono bordi sicuri: un solo blocco.
+template <class Layout = Mu5Layout, class Sink>
+void ForEachPairParallel(const std::vector<unsigned int>& CH,
+                         const std::vector<unsigned int>& CT,
+                         const PairingParams& params,
+                         Sink&& sink,
+                         PairingSummary* summary = nullptr,
+                         unsigned int nThreads = 0)
+{
+    const std::size_t N = std::min(CH.size(), CT.size());
+    if (nThreads == 0) nThreads = DefaultThreads();
+
+    // ------------------------------------------------------------
+    // 1) Bordi dei blocchi: primo START dopo un reset, ~4 blocchi per thread
+    // ------------------------------------------------------------
+    const std::size_t MIN_ROWS = (std::size_t)1 << 14;
+    std::size_t nTasks = std::min<std::size_t>(detail::TASKS_PER_THREAD * nThreads, N / MIN_ROWS);
+    nTasks = std::max<std::size_t>(1, nTasks);
+    if (!Layout::HAS_RESET) nTasks = 1;
+
+    std::vector<std::size_t> bounds(1, 0);
+    for (std::size_t t = 1; t < nTasks; ++t) {
+        std::size_t b = detail::NextStartAfterReset<Layout>(CH, std::max(bounds.back() + 1, N * t / nTasks));
+        if (b >= N) break;
+        bounds.push_back(b);
+    }
+    bounds.push_back(N);
+    nTasks = bounds.size() - 1;
+
+    // ------------------------------------------------------------
+    // 2) Reset visti prima di ogni bordo (conteggio parallelo + somma)
+    // ------------------------------------------------------------
+    std::vector<long long> resetsIn(nTasks, 0);
+    ParallelFor(nTasks, nThreads, [&](std::size_t t, unsigned int) {
+        long long n = 0;
+        for (std::size_t r = bounds[t]; r < bounds[t + 1]; ++r) n += Layout::IsReset(CH[r]) ? 1 : 0;
+        resetsIn[t] = n;
+    });
+    std::vector<long long> resetsBefore(nTasks, 0);
+    for (std::size_t t = 1; t < nTasks; ++t) resetsBefore[t] = resetsBefore[t - 1] + resetsIn[t - 1];
+
+    std::size_t firstReset = 0;
+    while (firstReset < N && !Layout::IsReset(CH[firstReset])) ++firstReset;
+
+    // ------------------------------------------------------------
+    // 3) Decodifica e pairing di ogni blocco
+    // ------------------------------------------------------------
+    const int window = std::max(params.earlyBlockWindow, params.finalBlockWindow);
+    const std::size_t CHUNK = 4096;
+
+    std::vector<std::size_t>     pairsIn(nTasks, 0);
+    std::vector<std::size_t>     eventsIn(nTasks, 0);
+    std::vector<PairingCounters> countersIn(nTasks);
+    std::vector<StageTimes>      timesIn(nTasks);
+
+    ParallelFor(nTasks, nThreads, [&](std::size_t t, unsigned int thread) {
+        const std::size_t begin = bounds[t];
+        const std::size_t end   = bounds[t + 1];
+
+        using Decoder = BasicFifoDecoder<Layout>;
+        using Engine  = BasicPairingEngine<Layout>;
+
+        Decoder decoder = (t == 0) ? Decoder() : Decoder(begin, resetsBefore[t]);
+        Engine  engine(params);
+        engine.SetCountLimit(end);   // gli START oltre il bordo sono del blocco dopo
+
+        // eventi utili che precedono il bordo, per le maschere dei blocchi
+        if (t > 0) {
+            std::vector<unsigned int> seed;
+            for (std::size_t r = begin; r > firstReset + 1 && (int)seed.size() < window; --r) {
+                if (detail::IsUsefulWord<Layout>(CH[r - 1])) seed.push_back(CH[r - 1]);
+            }
+            for (std::size_t k = seed.size(); k > 0; --k) engine.Seed(seed[k - 1]);
+        }
+
+        EventStore             events;
+        std::vector<DecayPair> pairs;
+        events.reserve(CHUNK);
+
+        auto keep = [&](const DecayPair& p) {
+            if (p.startRow >= end) return;
+            sink(p, t, thread);
+            ++pairsIn[t];
+        };
+
+        StageTimes& times = timesIn[t];
+        detail::StageClock::time_point t0 = detail::StageClock::now();
+
+        std::size_t row = begin;
+        while (row < N) {
+            std::size_t n = std::min(CHUNK, N - row);
+            events.clear();
+            decoder.Decode(CH.data() + row, CT.data() + row, n, events);
+            for (std::size_t r : events.row) eventsIn[t] += (r < end) ? 1 : 0;
+            times.decode += detail::SecondsSince(t0);
+
+            pairs.clear();
+            engine.Process(events, pairs);
+            times.pair += detail::SecondsSince(t0);
+            for (const DecayPair& p : pairs) keep(p);
+            times.sink += detail::SecondsSince(t0);
+            row += n;
+
+            // oltre il bordo: ci si ferma quando nessuna coppia nostra è aperta
+            if (row >= end) {
+                std::size_t open = engine.OpenStartRow();
+                if (open == Engine::NO_ROW || open >= end) break;
+            }
+        }
+        if (row >= N) {
+            pairs.clear();
+            engine.Finish(pairs);
+            for (const DecayPair& p : pairs) keep(p);
+        }
+        countersIn[t] = engine.Counters();
+    });
+
+    PairingSummary s;
+    s.rows = N;
+    for (std::size_t t = 0; t < nTasks; ++t) {
+        s.events += eventsIn[t];
+        s.pairs  += pairsIn[t];
+        s.counters.Add(countersIn[t]);
+        s.times.decode += timesIn[t].decode;
+        s.times.pair   += timesIn[t].pair;
+        s.times.sink   += timesIn[t].sink;
+    }
+    if (summary != nullptr) *summary = s;
+}
+
+// Come sopra, con le coppie rese in out nello stesso ordine del caso
+// sequenziale.
+inline void PairFifoParallel(const std::vector<unsigned int>& CH,
+                             const std::vector<unsigned int>& CT,
+                             const PairingParams& params,
+                             std::vector<DecayPair>& out,
+                             PairingSummary* summary = nullptr,
+                             unsigned int nThreads = 0)
+{
+    if (nThreads == 0) nThreads = DefaultThreads();
+
+    // un vettore per blocco, uniti nell'ordine dei blocchi
+    std::vector<std::vector<DecayPair>> results(detail::TASKS_PER_THREAD * nThreads);
+    ForEachPairParallel(CH, CT, params,
+                        [&](const DecayPair& p, std::size_t task, unsigned int) {
+                            results[task].push_back(p);
+                        },
+                        summary, nThreads);
+    for (const std::vector<DecayPair>& r : results) out.insert(out.end(), r.begin(), r.end());
+}
+
+} // namespace mulife
+
+#endif // MULIFE_PARALLELPAIRING_H
@@ -0,0 +1,314 @@
+#ifndef MULIFE_PARAMETERSCAN_H
+#define MULIFE_PARAMETERSCAN_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "FifoBinary.h"
+#include "LifetimeFit.h"
+#include "MuDecoding.h"
+#include "PairingEngine.h"
+#include "Parallel.h"
+
+// =====================================================================
+//        SCANSIONE DEI PARAMETRI DI PAIRING E FIT (senza rilettura)
+// =====================================================================
+//
+// Per studiare come tau dipende da EARLY_STOP_MAX_TICKS,
+// FINAL_STOP_MAX_US, EARLY/FINAL_BLOCK_WINDOW e dalla finestra
+// [tmin, tmax] del fit, invece di rilanciare Mu_life_new per ogni
+// valore:
+//
+//   1) ogni presa dati è letta e decodificata una volta sola in un
+//      EventStore (LoadEvents), poi usato solo in lettura;
+//   2) pairing: un task per ogni combinazione distinta di (early,
+//      finalUs, earlyBW, finalBW) e per ogni presa, in parallelo sugli
+//      stessi EventStore. La finestra [tmin, tmax] non cambia la
+//      macchina a stati (coppia accettata o fuori finestra portano
+//      allo stesso stato), quindi si accoppia una volta con la finestra
+//      piena [0, finalStopMaxUs] e si taglia dopo;
+//   3) fit: un task per punto della griglia (taglio in tick come nel
+//      pairing, poi FitLifetimeUnbinned), in parallelo.
+//
+// Il risultato di ogni punto coincide con quello di AnalyzeLifetime con
+// gli stessi parametri. Con più prese le coppie sono sommate (un solo
+// fit per punto).
+// =====================================================================
+
+namespace mulife {
+
+// Valori da provare per ogni parametro (griglia = prodotto cartesiano)
+struct ScanGrid {
+    std::vector<int>    earlyStopMaxEvents{EARLY_STOP_MAX_TICKS};
+    std::vector<double> finalStopMaxUs{FINAL_STOP_MAX_US};
+    std::vector<int>    earlyBlockWindow{EARLY_BLOCK_WINDOW};
+    std::vector<int>    finalBlockWindow{FINAL_BLOCK_WINDOW};
+    std::vector<double> tmin{0.0};
+    std::vector<double> tmax{20.0};
+    double              tickUs = tick_us;   // tick del contatore [µs], uguale per tutti i punti
+
+    std::size_t Size() const
+    {
+        return earlyStopMaxEvents.size() * finalStopMaxUs.size() * earlyBlockWindow.size() *
+               finalBlockWindow.size() * tmin.size() * tmax.size();
+    }
+};
+
+struct ScanPoint {
+    PairingParams     params;
+    std::size_t       pairs  = 0;        // coppie in [tmin, tmax]
+    std::size_t       pmt[4] = {0, 0, 0, 0};   // di cui con stop su PMT 8 … 11
+    LifetimeFitResult fit;
+    bool              fitOk  = false;
+};
+
+// Legge e decodifica un file intero in ev (svuotato). rows, se non
+// nullo, riceve il numero di righe lette. Ritorna false se il file non
+// può essere aperto.
+inline bool LoadEvents(const char* path, EventStore& ev, std::size_t* rows = nullptr,
+                       std::size_t chunkRows = (std::size_t)1 << 16)
+{
+    ev.clear();
+    FifoStream in;
+    if (!in.Open(path)) return false;
+
+    FifoDecoder decoder;
+    std::vector<unsigned int> CH;
+    std::vector<unsigned int> CT;
+    while (in.Next(CH, CT, chunkRows) > 0) {
+        decoder.Decode(CH.data(), CT.data(), CH.size(), ev);
+    }
+    if (rows != nullptr) *rows = decoder.Rows();
+    return true;
+}
+
+// Lista di valori da testo: "10", "5,10,20" oppure "inizio:fine:passo"
+// (estremi compresi), anche mescolati: "0,0.5:2:0.5". Ritorna false se
+// il testo non è valido.
+inline bool ParseScanList(const std::string& text, std::vector<double>& values)
+{
+    values.clear();
+    std::size_t pos = 0;
+    while (pos <= text.size()) {
+        std::size_t comma = text.find(',', pos);
+        if (comma == std::string::npos) comma = text.size();
+        std::string item = text.substr(pos, comma - pos);
+        pos = comma + 1;
+
+        double v[3] = {0.0, 0.0, 0.0};
+        int nv = 0;
+        const char* p = item.c_str();
+        for (;;) {
+            char* end = nullptr;
+            if (nv == 3) return false;
+            v[nv++] = std::strtod(p, &end);
+            if (end == p) return false;
+            p = end;
+            if (*p == '\0') break;
+            if (*p != ':') return false;
+            ++p;
+        }
+
+        if (nv == 1) {
+            values.push_back(v[0]);
+        } else if (nv == 3 && v[2] > 0.0 && v[1] >= v[0]) {
+            // numero di passi arrotondato: 0:2:0.1 comprende 2
+            long long steps = (long long)((v[1] - v[0]) / v[2] + 1e-9);
+            for (long long k = 0; k <= steps; ++k) values.push_back(v[0] + (double)k * v[2]);
+        } else {
+            return false;
+        }
+    }
+    return !values.empty();
+}
+
+inline bool ParseScanList(const std::string& text, std::vector<int>& values)
+{
+    std::vector<double> v;
+    if (!ParseScanList(text, v)) return false;
+    values.clear();
+    for (double x : v) values.push_back((int)std::lround(x));
+    return true;
+}
+
+// Esegue la griglia sugli EventStore di una o più prese. I punti escono
+// in out nell'ordine (early, finalUs, earlyBW, finalBW, tmin, tmax), con
+// l'ultimo indice che varia più in fretta.
+inline void ScanLifetime(const std::vector<const EventStore*>& takes,
+                         const ScanGrid& grid, std::vector<ScanPoint>& out,
+                         unsigned int nThreads = 0)
+{
+    const double tickUs = grid.tickUs;
+    out.clear();
+    if (nThreads == 0) nThreads = DefaultThreads();
+
+    // ------------------------------------------------------------
+    // 1) Combinazioni distinte dei parametri della macchina a stati
+    // ------------------------------------------------------------
+    std::vector<PairingParams> keys;
+    for (int early : grid.earlyStopMaxEvents)
+        for (double finalUs : grid.finalStopMaxUs)
+            for (int ebw : grid.earlyBlockWindow)
+                for (int fbw : grid.finalBlockWindow) {
+                    PairingParams p;
+                    p.earlyStopMaxEvents = early;
+                    p.finalStopMaxUs     = finalUs;
+                    p.earlyBlockWindow   = ebw;
+                    p.finalBlockWindow   = fbw;
+                    p.tmin               = 0.0;       // finestra piena: si taglia dopo
+                    p.tmax               = finalUs;
+                    p.tickUs             = tickUs;
+                    keys.push_back(p);
+                }
+
+    // ------------------------------------------------------------
+    // 2) Pairing: un task per (combinazione, presa)
+    // ------------------------------------------------------------
+    struct CompactPair {
+        long long    dtTicks;
+        unsigned int stopBlocks;
+    };
+    const std::size_t nTakes = takes.size();
+    std::vector<std::vector<CompactPair>> pairs(keys.size() * nTakes);
+
+    ParallelFor(pairs.size(), nThreads, [&](std::size_t task, unsigned int) {
+        const EventStore& ev = *takes[task % nTakes];
+        PairingEngine engine(keys[task / nTakes]);
+        std::vector<DecayPair> found;
+        engine.Process(ev, found);
+        engine.Finish(found);
+
+        std::vector<CompactPair>& dst = pairs[task];
+        dst.reserve(found.size());
+        for (const DecayPair& p : found) dst.push_back(CompactPair{p.dtTicks, p.stopBlocks});
+    });
+
+    // ------------------------------------------------------------
+    // 3) Taglio in [tmin, tmax] e fit: un task per punto
+    // ------------------------------------------------------------
+    const std::size_t nCuts = grid.tmin.size() * grid.tmax.size();
+    out.resize(keys.size() * nCuts);
+    std::vector<std::vector<double>> buffers(nThreads);
+
+    ParallelFor(out.size(), nThreads, [&](std::size_t k, unsigned int thread) {
+        const std::size_t key = k / nCuts;
+        ScanPoint& pt = out[k];
+        pt.params      = keys[key];
+        pt.params.tmin = grid.tmin[(k % nCuts) / grid.tmax.size()];
+        pt.params.tmax = grid.tmax[k % grid.tmax.size()];
+
+        // stesso taglio del pairing (in tick) e dello stesso fit (in µs)
+        const long long lo = CeilTicks(pt.params.tmin, tickUs);
+        const long long hi = FloorTicks(pt.params.tmax, tickUs);
+
+        std::vector<double>& t = buffers[thread];
+        t.clear();
+        for (std::size_t take = 0; take < nTakes; ++take) {
+            for (const CompactPair& p : pairs[key * nTakes + take]) {
+                if (p.dtTicks < lo || p.dtTicks > hi) continue;
+                ++pt.pairs;
+                if (p.stopBlocks & BIT_B8)  ++pt.pmt[0];
+                if (p.stopBlocks & BIT_B9)  ++pt.pmt[1];
+                if (p.stopBlocks & BIT_B10) ++pt.pmt[2];
+                if (p.stopBlocks & BIT_B11) ++pt.pmt[3];
+
+                double dt = (double)p.dtTicks * tickUs;
+                if (dt >= pt.params.tmin && dt <= pt.params.tmax) t.push_back(dt);
+            }
+        }
+        pt.fitOk = FitLifetimeUnbinned(t.data(), t.size(), pt.params.tmin, pt.params.tmax, pt.fit);
+    });
+}
+
+// Conteggi e tempi di una scansione su file
+struct ScanInfo {
+    std::size_t files   = 0;
+    std::size_t rows    = 0;
+    std::size_t events  = 0;
+    double      readSec = 0.0;   // lettura e decodifica di tutti i file
+    double      scanSec = 0.0;   // pairing e fit di tutta la griglia
+    std::string failed;          // primo file che non è stato possibile aprire
+};
+
+// Come sopra a partire dai file: ognuno è letto e decodificato una volta
+// (un file per thread), poi si esegue la griglia. Ritorna false se un
+// file non può essere aperto (il suo nome è in info->failed).
+inline bool ScanLifetime(const std::vector<std::string>& files, const ScanGrid& grid,
+                         std::vector<ScanPoint>& out, unsigned int nThreads = 0,
+                         ScanInfo* info = nullptr)
+{
+    ScanInfo si;
+    si.files = files.size();
+    out.clear();
+
+    detail::StageClock::time_point t0 = detail::StageClock::now();
+    std::vector<EventStore>  stores(files.size());
+    std::vector<std::size_t> rows(files.size(), 0);
+    std::vector<char>        loaded(files.size(), 0);
+    ParallelFor(files.size(), nThreads, [&](std::size_t k, unsigned int) {
+        loaded[k] = LoadEvents(files[k].c_str(), stores[k], &rows[k]) ? 1 : 0;
+    });
+
+    std::vector<const EventStore*> takes;
+    for (std::size_t k = 0; k < files.size(); ++k) {
+        if (!loaded[k]) {
+            si.failed = files[k];
+            if (info != nullptr) *info = si;
+            return false;
+        }
+        takes.push_back(&stores[k]);
+        si.rows   += rows[k];
+        si.events += stores[k].size();
+    }
+    si.readSec = detail::SecondsSince(t0);
+
+    ScanLifetime(takes, grid, out, nThreads);
+    si.scanSec = detail::SecondsSince(t0);
+    if (info != nullptr) *info = si;
+    return true;
+}
+
+// Tabella dei punti: colonne allineate, oppure CSV con csv = true
+inline void WriteScanTable(std::ostream& os, const std::vector<ScanPoint>& points, bool csv = false)
+{
+    const char* head = csv
+        ? "early,finalUs,earlyBW,finalBW,tmin,tmax,pairs,pmt8,pmt9,pmt10,pmt11,"
+          "tau,tauErr,bkgFrac,bkgFracErr,converged\n"
+        : "  early finalUs ebw fbw    tmin    tmax    coppie   PMT8   PMT9  PMT10  PMT11"
+          "        tau [µs]           fondo\n";
+    os << head;
+
+    char buf[256];
+    for (const ScanPoint& pt : points) {
+        const PairingParams& p = pt.params;
+        if (csv) {
+            std::snprintf(buf, sizeof(buf),
+                          "%d,%g,%d,%d,%g,%g,%zu,%zu,%zu,%zu,%zu,%.8g,%.8g,%.8g,%.8g,%d\n",
+                          p.earlyStopMaxEvents, p.finalStopMaxUs, p.earlyBlockWindow,
+                          p.finalBlockWindow, p.tmin, p.tmax, pt.pairs,
+                          pt.pmt[0], pt.pmt[1], pt.pmt[2], pt.pmt[3],
+                          pt.fit.tau, pt.fit.tauErr, pt.fit.bkgFrac, pt.fit.bkgFracErr,
+                          pt.fitOk ? 1 : 0);
+        } else {
+            std::snprintf(buf, sizeof(buf),
+                          "  %5d %7g %3d %3d %7g %7g %9zu %6zu %6zu %6zu %6zu"
+                          "  %7.4f ± %-7.4f %6.4f%s\n",
+                          p.earlyStopMaxEvents, p.finalStopMaxUs, p.earlyBlockWindow,
+                          p.finalBlockWindow, p.tmin, p.tmax, pt.pairs,
+                          pt.pmt[0], pt.pmt[1], pt.pmt[2], pt.pmt[3],
+                          pt.fit.tau, pt.fit.tauErr, pt.fit.bkgFrac,
+                          pt.fitOk ? "" : "  (fit non convergente)");
+        }
+        os << buf;
+    }
+}
+
+} // namespace mulife
+
+#endif // MULIFE_PARAMETERSCAN_H
@@ -0,0 +1,235 @@
+#ifndef MULIFE_PIPELINE_H
+#define MULIFE_PIPELINE_H
+
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "PairingEngine.h"
+#include "SpscRing.h"
+
+// =====================================================================
+//       PIPELINE LETTURA → DECODIFICA → PAIRING → ISTOGRAMMI
+// =====================================================================
+//
+// Stessa catena di StreamPairs, ma con ogni stadio su un thread e gli
+// stadi collegati da code SPSC limitate (SpscRing.h):
+//
+//   [lettura]  --righe-->  [decodifica]  --eventi-->  [pairing]  --coppie-->  [sink]
+//    thread        q1         thread         q2         thread        q3     chiamante
+//
+// Mentre il pairing lavora sul blocco k, la lettura sta già facendo il
+// parsing del blocco k+1 e il sink (di solito il riempimento degli
+// istogrammi) consuma le coppie del blocco k-1. Il sink gira nel thread
+// chiamante, quindi può toccare oggetti ROOT senza lock.
+//
+// I buffer non vengono riallocati a ogni blocco: il consumatore li
+// rimanda al produttore su una coda di ritorno. Le coppie, e il loro
+// ordine, sono le stesse di StreamPairs.
+//
+// Per ogni stadio si misurano elementi trattati, tempo di lavoro e tempo
+// passato ad aspettare le code; per ogni coda l'occupazione vista dal
+// consumatore. Una coda quasi sempre piena indica che lo stadio a valle
+// è il collo di bottiglia, una quasi sempre vuota che lo è quello a monte.
+// =====================================================================
+
+namespace mulife {
+
+struct StageStats {
+    std::size_t chunks   = 0;     // blocchi trattati
+    std::size_t items    = 0;     // righe lette, eventi decodificati/accoppiati, coppie nel sink
+    double      busySec  = 0.0;   // tempo di lavoro
+    double      waitSec  = 0.0;   // tempo bloccato su code vuote o piene
+
+    double ItemsPerSec() const { return (busySec > 0.0) ? items / busySec : 0.0; }
+};
+
+struct QueueStats {
+    std::size_t capacity = 0;
+    std::size_t samples  = 0;     // letture dalla coda
+    std::size_t maxFill  = 0;     // occupazione massima osservata
+    double      sumFill  = 0.0;
+
+    double MeanFill() const { return (samples > 0) ? sumFill / samples : 0.0; }
+};
+
+struct PipelineStats {
+    StageStats read, decode, pair, sink;
+    QueueStats rowsQueue, eventsQueue, pairsQueue;
+    double     wallSec = 0.0;
+};
+
+namespace detail {
+
+using PipeClock = StageClock;
+
+struct RowChunk {
+    std::vector<unsigned int> CH;
+    std::vector<unsigned int> CT;
+};
+
+// Coda di blocchi pieni più coda di ritorno dei buffer vuoti
+template <class T>
+struct PipeLink {
+    explicit PipeLink(std::size_t depth) : full(depth), free(depth + 2) {}
+
+    // Buffer vuoto da riempire (riciclato se disponibile)
+    T Acquire()
+    {
+        T item;
+        free.TryPop(item);
+        return item;
+    }
+
+    void Send(T& item, StageStats& st, PipeClock::time_point& t0)
+    {
+        st.busySec += SecondsSince(t0);
+        full.Push(item);
+        st.waitSec += SecondsSince(t0);
+    }
+
+    bool Receive(T& item, StageStats& st, QueueStats& qs, PipeClock::time_point& t0)
+    {
+        st.busySec += SecondsSince(t0);
+        std::size_t fill = full.Size();
+        bool ok = full.Pop(item);
+        st.waitSec += SecondsSince(t0);
+        if (ok) {
+            ++qs.samples;
+            qs.sumFill += (double)fill;
+            if (fill > qs.maxFill) qs.maxFill = fill;
+        }
+        return ok;
+    }
+
+    // Il consumatore restituisce il buffer; se la coda di ritorno è
+    // piena il buffer viene semplicemente liberato
+    void Release(T& item) { free.TryPush(item); }
+
+    SpscRing<T> full;
+    SpscRing<T> free;
+};
+
+} // namespace detail
+
+// Lettura, decodifica e pairing in pipeline, a blocchi di chunkRows
+// righe con al più queueDepth blocchi in coda tra due stadi.
+// sink(const DecayPair&) viene chiamato nel thread chiamante, in ordine.
+// Ritorna false se il file non può essere aperto.
+template <class Layout = Mu5Layout, class Sink>
+bool PipelinePairs(const char* path, const PairingParams& params, Sink&& sink,
+                   PairingSummary* summary = nullptr,
+                   PipelineStats* stats = nullptr,
+                   std::size_t chunkRows = (std::size_t)1 << 16,
+                   std::size_t queueDepth = 8)
+{
+    using detail::PipeClock;
+
+    FifoStream in;
+    if (!in.Open(path)) return false;
+
+    PipelineStats st;
+    PipeClock::time_point tStart = PipeClock::now();
+
+    detail::PipeLink<detail::RowChunk>       rowsLink(queueDepth);
+    detail::PipeLink<EventStore>             eventsLink(queueDepth);
+    detail::PipeLink<std::vector<DecayPair>> pairsLink(queueDepth);
+    st.rowsQueue.capacity   = rowsLink.full.Capacity();
+    st.eventsQueue.capacity = eventsLink.full.Capacity();
+    st.pairsQueue.capacity  = pairsLink.full.Capacity();
+
+    BasicFifoDecoder<Layout>   decoder;
+    BasicPairingEngine<Layout> engine(params);
+
+    // 1) lettura / parsing
+    std::thread reader([&]() {
+        PipeClock::time_point t0 = PipeClock::now();
+        for (;;) {
+            detail::RowChunk c = rowsLink.Acquire();
+            if (in.Next(c.CH, c.CT, chunkRows) == 0) break;
+            ++st.read.chunks;
+            st.read.items += c.CH.size();
+            rowsLink.Send(c, st.read, t0);
+        }
+        st.read.busySec += detail::SecondsSince(t0);
+        rowsLink.full.Close();
+    });
+
+    // 2) decodifica righe → eventi
+    std::thread decode([&]() {
+        PipeClock::time_point t0 = PipeClock::now();
+        detail::RowChunk c;
+        while (rowsLink.Receive(c, st.decode, st.rowsQueue, t0)) {
+            EventStore ev = eventsLink.Acquire();
+            ev.clear();
+            decoder.Decode(c.CH.data(), c.CT.data(), c.CH.size(), ev);
+            rowsLink.Release(c);
+
+            ++st.decode.chunks;
+            st.decode.items += ev.size();
+            eventsLink.Send(ev, st.decode, t0);
+        }
+        st.decode.busySec += detail::SecondsSince(t0);
+        eventsLink.full.Close();
+    });
+
+    // 3) pairing
+    std::thread pairer([&]() {
+        PipeClock::time_point t0 = PipeClock::now();
+        EventStore ev;
+        while (eventsLink.Receive(ev, st.pair, st.eventsQueue, t0)) {
+            std::vector<DecayPair> pairs = pairsLink.Acquire();
+            pairs.clear();
+            engine.Process(ev, pairs);
+            ++st.pair.chunks;
+            st.pair.items += ev.size();
+            eventsLink.Release(ev);
+
+            if (!pairs.empty()) pairsLink.Send(pairs, st.pair, t0);
+        }
+        std::vector<DecayPair> pairs = pairsLink.Acquire();
+        pairs.clear();
+        engine.Finish(pairs);
+        if (!pairs.empty()) pairsLink.Send(pairs, st.pair, t0);
+        st.pair.busySec += detail::SecondsSince(t0);
+        pairsLink.full.Close();
+    });
+
+    // 4) sink nel thread chiamante
+    {
+        PipeClock::time_point t0 = PipeClock::now();
+        std::vector<DecayPair> pairs;
+        while (pairsLink.Receive(pairs, st.sink, st.pairsQueue, t0)) {
+            for (const DecayPair& p : pairs) sink(p);
+            ++st.sink.chunks;
+            st.sink.items += pairs.size();
+            pairsLink.Release(pairs);
+        }
+        st.sink.busySec += detail::SecondsSince(t0);
+    }
+
+    reader.join();
+    decode.join();
+    pairer.join();
+
+    st.wallSec = std::chrono::duration<double>(PipeClock::now() - tStart).count();
+
+    if (summary != nullptr) {
+        summary->rows         = decoder.Rows();
+        summary->events       = engine.Events();
+        summary->pairs        = st.sink.items;
+        summary->counters     = engine.Counters();
+        summary->times.read   = st.read.busySec;
+        summary->times.decode = st.decode.busySec;
+        summary->times.pair   = st.pair.busySec;
+        summary->times.sink   = st.sink.busySec;
+    }
+    if (stats != nullptr) *stats = st;
+    return true;
+}
+
+} // namespace mulife
+
+#endif // MULIFE_PIPELINE_H
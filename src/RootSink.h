@@ -0,0 +1,168 @@
+#ifndef MULIFE_ROOTSINK_H
+#define MULIFE_ROOTSINK_H
+
+#include <algorithm>
+#include <vector>
+
+#include "TF1.h"
+#include "TFile.h"
+#include "TH1F.h"
+
+#include "Histogram.h"
+#include "LifetimeAnalysis.h"
+#include "MuDecoding.h"
+
+// =====================================================================
+//                   SINK ROOT (istogrammi, fit, file)
+// =====================================================================
+//
+// Unico header che usa ROOT: tutto il calcolo (decodifica, pairing,
+// istogrammi, fit unbinned) sta negli header senza ROOT (MuLife.h);
+// qui i risultati diventano TH1F, TF1 e file .root. Usato dalle macro
+// (Mu_life5.cpp) e da mulife se compilato con ROOT.
+// =====================================================================
+
+namespace mulife {
+
+struct DecayHistos {
+    TH1F* hDecay;
+    TH1F* hDecay_B8;
+    TH1F* hDecay_B9;
+    TH1F* hDecay_B10;
+    TH1F* hDecay_B11;
+};
+
+// Gli istogrammi finiscono nella directory corrente di ROOT
+inline DecayHistos BookDecayHistos(int nbins, double tmin, double tmax)
+{
+    DecayHistos h;
+    h.hDecay = new TH1F("hDecay",
+                        "Muon decay time; t_{decay} [#mu s]; Counts",
+                        nbins, tmin, tmax);
+
+    // Istogrammi separati per i diversi PMT del blocco
+    h.hDecay_B8  = new TH1F("hDecay_B8",
+                            "Muon decay time (stop PMT 8); t_{decay} [#mu s]; Counts",
+                            nbins, tmin, tmax);
+    h.hDecay_B9  = new TH1F("hDecay_B9",
+                            "Muon decay time (stop PMT 9); t_{decay} [#mu s]; Counts",
+                            nbins, tmin, tmax);
+    h.hDecay_B10 = new TH1F("hDecay_B10",
+                            "Muon decay time (stop PMT 10); t_{decay} [#mu s]; Counts",
+                            nbins, tmin, tmax);
+    h.hDecay_B11 = new TH1F("hDecay_B11",
+                            "Muon decay time (stop PMT 11); t_{decay} [#mu s]; Counts",
+                            nbins, tmin, tmax);
+    return h;
+}
+
+// Riempiamo l'istogramma totale e quelli per PMT in base alla maschera dei blocchi
+inline void FillDecayHistos(DecayHistos& h,
+                            const std::vector<double>& dt_values,
+                            const std::vector<unsigned int>& stopBlocks)
+{
+    for (std::size_t k = 0; k < dt_values.size(); ++k) {
+        double dt = dt_values[k];
+        unsigned int sb = (k < stopBlocks.size()) ? stopBlocks[k] : 0u;
+
+        h.hDecay->Fill(dt);
+
+        if (sb & BIT_B8)  h.hDecay_B8->Fill(dt);
+        if (sb & BIT_B9)  h.hDecay_B9->Fill(dt);
+        if (sb & BIT_B10) h.hDecay_B10->Fill(dt);
+        if (sb & BIT_B11) h.hDecay_B11->Fill(dt);
+    }
+}
+
+// Copia esatta di un FixedHistogram (riempito anche da più thread) in un
+// TH1F con lo stesso binning: contenuti con under/overflow, entries e
+// statistiche per media/RMS
+inline void ToTH1F(const FixedHistogram& src, TH1F* h)
+{
+    for (int b = 0; b <= src.NBins() + 1; ++b) {
+        h->SetBinContent(b, (double)src.BinContent(b));
+    }
+    // SetBinContent azzera le statistiche: vanno rimesse dopo
+    double stats[4];
+    src.GetStats(stats);
+    h->PutStats(stats);
+    h->SetEntries((double)src.Entries());
+}
+
+inline void SpectraToHistos(const DecaySpectra& s, DecayHistos& h)
+{
+    ToTH1F(s.all,    h.hDecay);
+    ToTH1F(s.pmt[0], h.hDecay_B8);
+    ToTH1F(s.pmt[1], h.hDecay_B9);
+    ToTH1F(s.pmt[2], h.hDecay_B10);
+    ToTH1F(s.pmt[3], h.hDecay_B11);
+}
+
+inline void WriteDecayHistos(const DecayHistos& h)
+{
+    h.hDecay->Write();
+    h.hDecay_B8->Write();
+    h.hDecay_B9->Write();
+    h.hDecay_B10->Write();
+    h.hDecay_B11->Write();
+}
+
+// Modello: N(t) = N0 * exp(-t/tau) + B
+inline TF1* FitDecay(TH1F* hDecay, double tmin, double tmax, const char* fname = "fExpBkg",
+                    const char* option = "LIR+")
+{
+    TF1* fExpBkg = new TF1(fname,
+                           "[0]*exp(-x/[1]) +[2]",
+                           tmin, tmax);
+    fExpBkg->SetParNames("N0", "tau", "B");
+
+    // Stime iniziali
+    fExpBkg->SetParameter(0, hDecay->GetMaximum());
+    fExpBkg->SetParameter(1, 2.2);   // µs, tempo di vita atteso
+
+    //Stima grezza del fondo costante dai bin di coda
+    double bkgGuess = 0.0;
+    int nb = hDecay->GetNbinsX();
+    int nTail = std::min(10, nb);
+    for (int ib = nb - nTail + 1; ib <= nb; ++ib) {
+      bkgGuess += hDecay->GetBinContent(ib);
+    }
+    bkgGuess /= (double)nTail;
+    fExpBkg->SetParameter(2, bkgGuess);
+
+    hDecay->Fit(fExpBkg, option);
+    return fExpBkg;
+}
+
+// Nuovo TH1F (nella directory corrente) copia di src
+inline TH1F* MakeTH1F(const FixedHistogram& src, const char* name, const char* title)
+{
+    TH1F* h = new TH1F(name, title, src.NBins(), src.XMin(), src.XMax());
+    ToTH1F(src, h);
+    return h;
+}
+
+// Sink ROOT di AnalyzeLifetime: istogrammi, fit binned e file .root.
+// Ritorna il fit binned (nullptr se il file non può essere creato).
+inline TF1* WriteLifetimeRoot(const LifetimeReport& rep, const char* output,
+                              const char* fitOption = "LIRQ+")
+{
+    TFile* fout = TFile::Open(output, "RECREATE");
+    if (fout == nullptr || fout->IsZombie()) return nullptr;
+
+    DecayHistos h = BookDecayHistos(rep.spectra.all.NBins(),
+                                    rep.spectra.all.XMin(), rep.spectra.all.XMax());
+    SpectraToHistos(rep.spectra, h);
+
+    TF1* fExpBkg = FitDecay(h.hDecay, rep.spectra.all.XMin(), rep.spectra.all.XMax(),
+                            "fExpBkg", fitOption);
+    WriteDecayHistos(h);
+    fExpBkg->Write();
+    fout->Close();
+    delete fout;
+    return fExpBkg;
+}
+
+} // namespace mulife
+
+#endif // MULIFE_ROOTSINK_H
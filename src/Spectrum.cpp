@@ -1,7 +1,116 @@
-#include <iostream>
-#include <fstream>
-#include <vector>
-#include <filesystem>
-#include <string>
-#include <algorithm>
-#include <cmath>
\ No newline at end of file
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <filesystem>
+#include <string>
+#include <algorithm>
+#include <cmath>
+
+// ROOT
+#include "TH1F.h"
+#include "TCanvas.h"
+#include "TFile.h"
+
+// Calcolo senza ROOT: lettura dei file wavedump, baseline, integrazione, spettri
+#include "WavedumpSpectrum.h"
+#include "TakeAnalysis.h"
+
+// Uscita ROOT: TH1F
+#include "RootSink.h"
+
+using namespace mulife;
+
+// =====================================================================
+//                             SPECTRUM
+// =====================================================================
+//
+// Spettri in ampiezza e in area dei segnali dell'integratore (PMT08–11
+// su CH0–CH3) per la misura della massa del muone (parte V del logbook).
+// path è un file wavedump o una cartella: in quel caso si prendono tutti
+// i .txt, analizzati in parallelo (nThreads, 0 = tutti i core) e letti
+// record per record (vedi WavedumpSpectrum.h). Con pulses = true ogni
+// canale conta l'impulso più ampio trovato da WavePulses.h (baseline
+// mobile, soglia con isteresi) invece del gate fisso.
+//
+// Disegna gli spettri in area dei quattro canali e quello somma, e salva
+// tutti gli istogrammi in output.
+
+void Spectrum(const char* path = "data/wavedump",
+              int baselineSamples = 64,
+              double threshold = 50.0,
+              int nThreads = 0,
+              const char* output = "Spectrum.root",
+              bool pulses = false)
+{
+    std::error_code ec;
+    std::vector<std::string> files;
+    if (std::filesystem::is_directory(path, ec)) {
+        files = FindTakes(path, "");
+    } else {
+        files.push_back(path);
+    }
+    if (files.empty()) {
+        std::cerr << "[ERRORE] Nessun file wavedump in " << path << "\n";
+        return;
+    }
+
+    WaveConfig config;
+    config.baselineSamples = baselineSamples;
+    config.threshold       = threshold;
+    config.findPulses      = pulses;
+
+    WaveSpectra sp;
+    WaveInfo    info;
+    if (!AnalyzeWavedump(files, config, sp, (unsigned int)std::max(nThreads, 0), &info)) {
+        std::cerr << "[ERRORE] Configurazione degli spettri non valida\n";
+        return;
+    }
+
+    std::cout << "[INFO] File: " << info.files << " (non aperti: " << info.failed
+              << "), campioni: " << info.rows << "\n";
+    WriteWaveSummary(std::cout, sp);
+
+    // istogrammi creati prima del file: restano disegnati dopo Close()
+    std::vector<TH1F*> hists;
+
+    TCanvas* c = new TCanvas("c_spectrum", "Spettri dell'integratore", 1200, 800);
+    c->Divide(3, 2);
+
+    const char* pmt[WAVE_CHANNELS] = {"PMT08", "PMT09", "PMT10", "PMT11"};
+    for (int k = 0; k < WAVE_CHANNELS; ++k) {
+        std::string name = "hAmp_CH" + std::to_string(k);
+        std::string title = std::string("Ampiezza ") + pmt[k];
+        TH1F* hAmp = MakeTH1F(sp.amp[k], name.c_str(), title.c_str());
+        hAmp->GetXaxis()->SetTitle("Ampiezza [ADC]");
+        hists.push_back(hAmp);
+
+        name  = "hArea_CH" + std::to_string(k);
+        title = std::string("Area ") + pmt[k];
+        TH1F* hArea = MakeTH1F(sp.area[k], name.c_str(), title.c_str());
+        hArea->GetXaxis()->SetTitle("Area [ADC x campioni]");
+        hists.push_back(hArea);
+
+        c->cd(k + 1);
+        hArea->Draw();
+    }
+
+    TH1F* hSumAmp = MakeTH1F(sp.sumAmp, "hAmp_sum", "Ampiezza, somma dei canali colpiti");
+    hSumAmp->GetXaxis()->SetTitle("Ampiezza [ADC]");
+    hists.push_back(hSumAmp);
+
+    TH1F* hSumArea = MakeTH1F(sp.sumArea, "hArea_sum", "Area, somma dei canali colpiti");
+    hSumArea->GetXaxis()->SetTitle("Area [ADC x campioni]");
+    hists.push_back(hSumArea);
+
+    c->cd(5);
+    hSumArea->Draw();
+
+    TFile* fout = TFile::Open(output, "RECREATE");
+    if (fout == nullptr || fout->IsZombie()) {
+        std::cerr << "[ERRORE] Impossibile creare " << output << "\n";
+        return;
+    }
+    for (TH1F* h : hists) h->Write();
+    fout->Close();
+    std::cout << "[INFO] Spettri salvati in " << output << "\n";
+}
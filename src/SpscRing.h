@@ -0,0 +1,93 @@
+#ifndef MULIFE_SPSCRING_H
+#define MULIFE_SPSCRING_H
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// =====================================================================
+//        CODA CIRCOLARE LIMITATA A UN PRODUTTORE / UN CONSUMATORE
+// =====================================================================
+//
+// Coda lock-free tra due thread (uno solo scrive, uno solo legge), usata
+// per collegare gli stadi della pipeline (Pipeline.h). Gli indici sono
+// contatori a 64 bit che crescono sempre; la posizione nell'array è
+// indice & (capacità - 1), con capacità potenza di 2. Ogni indice è
+// scritto da un solo thread: bastano load/store acquire-release, senza
+// compare-and-swap. I due indici stanno su linee di cache diverse.
+//
+// Close() segnala al consumatore che non arriverà altro: Pop ritorna
+// false quando la coda è vuota e chiusa.
+// =====================================================================
+
+namespace mulife {
+
+template <class T>
+class SpscRing {
+public:
+    explicit SpscRing(std::size_t capacity)
+    {
+        std::size_t cap = 1;
+        while (cap < capacity) cap <<= 1;
+        slots_.resize(cap);
+        mask_ = cap - 1;
+    }
+
+    std::size_t Capacity() const { return slots_.size(); }
+
+    // Elementi in coda (approssimato se chiamato da un terzo thread)
+    std::size_t Size() const
+    {
+        return (std::size_t)(tail_.load(std::memory_order_acquire) -
+                             head_.load(std::memory_order_acquire));
+    }
+
+    bool TryPush(T& item)
+    {
+        const unsigned long long t = tail_.load(std::memory_order_relaxed);
+        if (t - head_.load(std::memory_order_acquire) == slots_.size()) return false;
+        slots_[t & mask_] = std::move(item);
+        tail_.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool TryPop(T& item)
+    {
+        const unsigned long long h = head_.load(std::memory_order_relaxed);
+        if (h == tail_.load(std::memory_order_acquire)) return false;
+        item = std::move(slots_[h & mask_]);
+        head_.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Versioni bloccanti: cedono il processore finché non c'è posto / un elemento
+    void Push(T& item)
+    {
+        while (!TryPush(item)) std::this_thread::yield();
+    }
+
+    bool Pop(T& item)
+    {
+        for (;;) {
+            if (TryPop(item)) return true;
+            if (closed_.load(std::memory_order_acquire)) return TryPop(item);
+            std::this_thread::yield();
+        }
+    }
+
+    void Close() { closed_.store(true, std::memory_order_release); }
+
+private:
+    std::vector<T> slots_;
+    std::size_t    mask_ = 0;
+
+    alignas(64) std::atomic<unsigned long long> head_{0};   // prossimo da leggere (consumatore)
+    alignas(64) std::atomic<unsigned long long> tail_{0};   // prossimo da scrivere (produttore)
+    alignas(64) std::atomic<bool>               closed_{false};
+};
+
+} // namespace mulife
+
+#endif // MULIFE_SPSCRING_H
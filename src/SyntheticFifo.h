@@ -0,0 +1,291 @@
+#ifndef MULIFE_SYNTHETICFIFO_H
+#define MULIFE_SYNTHETICFIFO_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <queue>
+#include <random>
+#include <vector>
+
+#include "FifoBinary.h"
+#include "MuDecoding.h"
+
+// =====================================================================
+//              GENERATORE DI FLUSSI FIFO SINTETICI
+// =====================================================================
+//
+// Produce righe "CH CT" con la stessa codifica dei file di Mu_life5
+// (Mu5Layout), per provare l'analisi su prese dati molto più lunghe di
+// quelle in data/Take e per avere una verità nota:
+//
+//   - muone fermato  : START (bit0), dopo earlyStopTicks lo stop
+//                      "immediato" (bit1 + PMT del blocco) e, con
+//                      probabilità decayFraction, lo STOP del
+//                      decadimento dopo un tempo esponenziale di vita
+//                      media tauUs;
+//   - START e STOP accidentali, processi di Poisson indipendenti;
+//   - PMT del blocco : ogni stop ha un PMT tra 8 e 11 con probabilità
+//                      blockProb; con probabilità splitBlockProb il bit
+//                      del PMT arriva in una riga a parte un tick dopo
+//                      (come "2 … / 16 …" nei file veri);
+//   - reset          : una parola 2^31 (CT = 2^31 + #reset) a ogni
+//                      multiplo di 2^30 tick, la prima al tempo 0.
+//
+// Le righe escono in ordine di tempo; gli stop futuri aspettano in una
+// piccola coda di priorità. SyntheticFifo::Next ha la stessa forma di
+// FifoStream::Next, quindi il generatore può alimentare direttamente
+// decoder e pairing; WriteSyntheticFifo scrive su file (testo o binario
+// di FifoBinary.h) a blocchi, con memoria costante.
+// A parità di parametri e seme il flusso è sempre lo stesso.
+// =====================================================================
+
+namespace mulife {
+
+struct SyntheticParams {
+    double        tauUs          = 2.197;   // vita media iniettata [µs]
+    double        muonRateHz     = 0.1;     // muoni fermati nel blocco
+    double        decayFraction  = 0.5;     // frazione di muoni con STOP di decadimento
+    double        accStartRateHz = 0.6;     // START accidentali
+    double        accStopRateHz  = 0.2;     // STOP accidentali
+    int           earlyStopTicks = 8;       // START → stop "immediato" [tick]
+    double        blockProb      = 0.9;     // stop con un PMT del blocco
+    double        splitBlockProb = 0.5;     // PMT in una riga separata (+1 tick)
+    double        tickUs         = tick_us;
+    std::uint64_t seed           = 1;
+};
+
+// Quello che è stato iniettato, per confrontarlo con la ricostruzione
+struct SyntheticTruth {
+    std::uint64_t rows      = 0;     // righe prodotte (reset compresi)
+    std::uint64_t resets    = 0;
+    std::uint64_t muons     = 0;
+    std::uint64_t decays    = 0;     // STOP di decadimento generati
+    std::uint64_t accStarts = 0;
+    std::uint64_t accStops  = 0;
+    long long     lastTicks = 0;     // tempo dell'ultima riga [tick]
+};
+
+class SyntheticFifo {
+public:
+    explicit SyntheticFifo(const SyntheticParams& params = SyntheticParams())
+        : p_(params), rng_(params.seed)
+    {
+        const double ticksPerSec = 1e6 / p_.tickUs;
+        tMuon_     = NextArrival(p_.muonRateHz, ticksPerSec, 0.0);
+        tAccStart_ = NextArrival(p_.accStartRateHz, ticksPerSec, 0.0);
+        tAccStop_  = NextArrival(p_.accStopRateHz, ticksPerSec, 0.0);
+    }
+
+    // Sostituisce il contenuto di CH e CT con le prossime maxRows righe
+    std::size_t Next(std::vector<unsigned int>& CH,
+                     std::vector<unsigned int>& CT,
+                     std::size_t maxRows)
+    {
+        CH.resize(maxRows);
+        CT.resize(maxRows);
+        for (std::size_t k = 0; k < maxRows; ++k) NextRow(CH[k], CT[k]);
+        return maxRows;
+    }
+
+    const SyntheticTruth& Truth() const { return truth_; }
+    const SyntheticParams& Params() const { return p_; }
+
+private:
+    struct Row {
+        long long     ticks;
+        std::uint64_t seq;    // a parità di tempo, ordine di generazione
+        unsigned int  ch;
+
+        bool operator>(const Row& o) const
+        {
+            return ticks != o.ticks ? ticks > o.ticks : seq > o.seq;
+        }
+    };
+
+    static constexpr long long RESET_TICKS = 1LL << COUNTER_BITS;
+
+    void NextRow(unsigned int& ch, unsigned int& ct)
+    {
+        const long long t = NextTime();
+
+        // reset dovuto prima della prossima riga
+        if (nextReset_ <= t) {
+            ch = RESET_FLAG;
+            ct = RESET_FLAG + (unsigned int)truth_.resets;
+            ++truth_.resets;
+            nextReset_ += RESET_TICKS;
+        } else {
+            Row r = queue_.top();
+            queue_.pop();
+            ch = r.ch;
+            ct = (unsigned int)(r.ticks & COUNTER_MASK);
+            truth_.lastTicks = r.ticks;
+        }
+        ++truth_.rows;
+    }
+
+    // Tempo della prossima riga in coda, dopo aver generato le sorgenti
+    // che cadono prima di lei
+    long long NextTime()
+    {
+        const double ticksPerSec = 1e6 / p_.tickUs;
+        for (;;) {
+            double next = std::min(tMuon_, std::min(tAccStart_, tAccStop_));
+            if (queue_.empty() && next == HUGE_VAL) return nextReset_;   // solo reset
+            if (!queue_.empty() && (double)queue_.top().ticks <= next) return queue_.top().ticks;
+
+            long long t = (long long)next;
+            if (next == tMuon_) {
+                GenerateMuon(t);
+                tMuon_ = NextArrival(p_.muonRateHz, ticksPerSec, tMuon_);
+            } else if (next == tAccStart_) {
+                Push(t, BIT_START);
+                ++truth_.accStarts;
+                tAccStart_ = NextArrival(p_.accStartRateHz, ticksPerSec, tAccStart_);
+            } else {
+                PushStop(t);
+                ++truth_.accStops;
+                tAccStop_ = NextArrival(p_.accStopRateHz, ticksPerSec, tAccStop_);
+            }
+        }
+    }
+
+    void GenerateMuon(long long t)
+    {
+        ++truth_.muons;
+        Push(t, BIT_START);
+        PushStop(t + p_.earlyStopTicks);
+        if (uniform_(rng_) < p_.decayFraction) {
+            double dtUs = -p_.tauUs * std::log(1.0 - uniform_(rng_));
+            PushStop(t + std::llround(dtUs / p_.tickUs));
+            ++truth_.decays;
+        }
+    }
+
+    // STOP con l'eventuale PMT del blocco, nella stessa riga o un tick dopo
+    void PushStop(long long t)
+    {
+        unsigned int block = 0u;
+        if (uniform_(rng_) < p_.blockProb) {
+            block = BIT_B8 << (unsigned int)(uniform_(rng_) * 4.0);
+        }
+        if (block != 0u && uniform_(rng_) < p_.splitBlockProb) {
+            Push(t, BIT_STOP);
+            Push(t + 1, block);
+        } else {
+            Push(t, BIT_STOP | block);
+        }
+    }
+
+    void Push(long long t, unsigned int ch)
+    {
+        queue_.push(Row{t, seq_++, ch});
+    }
+
+    // Arrivo successivo di un processo di Poisson (infinito se rate = 0)
+    double NextArrival(double rateHz, double ticksPerSec, double from)
+    {
+        if (!(rateHz > 0.0)) return HUGE_VAL;
+        return from + 1.0 - std::log(1.0 - uniform_(rng_)) * ticksPerSec / rateHz;
+    }
+
+    SyntheticParams p_;
+    SyntheticTruth  truth_;
+
+    std::mt19937_64                        rng_;
+    std::uniform_real_distribution<double> uniform_{0.0, 1.0};
+
+    double tMuon_     = 0.0;
+    double tAccStart_ = 0.0;
+    double tAccStop_  = 0.0;
+
+    long long     nextReset_ = 0;
+    std::uint64_t seq_       = 0;
+    std::priority_queue<Row, std::vector<Row>, std::greater<Row>> queue_;
+};
+
+namespace detail {
+
+// Scrive v in decimale a partire da p; ritorna la fine
+inline char* FormatUInt(char* p, unsigned int v)
+{
+    char tmp[10];
+    int n = 0;
+    do {
+        tmp[n++] = (char)('0' + v % 10u);
+        v /= 10u;
+    } while (v != 0u);
+    while (n > 0) *p++ = tmp[--n];
+    return p;
+}
+
+} // namespace detail
+
+// Scrive nRows righe generate in path, come testo "CH CT" o nel formato
+// binario di FifoBinary.h. Ritorna false se il file non può essere scritto.
+inline bool WriteSyntheticFifo(const char* path, const SyntheticParams& params,
+                               std::uint64_t nRows, bool binary = false,
+                               SyntheticTruth* truth = nullptr)
+{
+    std::FILE* f = std::fopen(path, "wb");
+    if (f == nullptr) return false;
+
+    SyntheticFifo gen(params);
+    bool ok = true;
+
+    FifoBinaryHeader hdr;
+    if (binary) {
+        std::memcpy(hdr.magic, FIFO_BINARY_MAGIC, sizeof(hdr.magic));
+        hdr.version    = FIFO_BINARY_VERSION;
+        hdr.recordSize = sizeof(FifoRecord);
+        hdr.tick_ns    = params.tickUs * 1e3;
+        hdr.nRows      = nRows;
+        hdr.nResets    = 0;   // aggiornato alla fine
+        ok = std::fwrite(&hdr, sizeof(hdr), 1, f) == 1;
+    }
+
+    const std::size_t BLOCK = 1u << 16;
+    std::vector<unsigned int> CH, CT;
+    std::vector<char>         buf(BLOCK * 22);
+    std::vector<FifoRecord>   rec;
+
+    for (std::uint64_t done = 0; ok && done < nRows;) {
+        std::size_t n = (std::size_t)std::min<std::uint64_t>(BLOCK, nRows - done);
+        gen.Next(CH, CT, n);
+        done += n;
+
+        if (binary) {
+            rec.resize(n);
+            for (std::size_t k = 0; k < n; ++k) rec[k] = FifoRecord{CH[k], CT[k]};
+            ok = std::fwrite(rec.data(), sizeof(FifoRecord), n, f) == n;
+        } else {
+            char* p = buf.data();
+            for (std::size_t k = 0; k < n; ++k) {
+                p = detail::FormatUInt(p, CH[k]);
+                *p++ = ' ';
+                p = detail::FormatUInt(p, CT[k]);
+                *p++ = '\n';
+            }
+            std::size_t bytes = (std::size_t)(p - buf.data());
+            ok = std::fwrite(buf.data(), 1, bytes, f) == bytes;
+        }
+    }
+
+    if (ok && binary) {
+        hdr.nResets = gen.Truth().resets;
+        ok = std::fseek(f, 0, SEEK_SET) == 0 && std::fwrite(&hdr, sizeof(hdr), 1, f) == 1;
+    }
+
+    ok = (std::fclose(f) == 0) && ok;
+    if (!ok) std::remove(path);
+    if (truth != nullptr) *truth = gen.Truth();
+    return ok;
+}
+
+} // namespace mulife
+
+#endif // MULIFE_SYNTHETICFIFO_H
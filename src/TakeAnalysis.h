@@ -0,0 +1,145 @@
+#ifndef MULIFE_TAKEANALYSIS_H
+#define MULIFE_TAKEANALYSIS_H
+
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "Histogram.h"
+#include "PairingEngine.h"
+#include "ParallelPairing.h"
+#include "Pipeline.h"
+
+// =====================================================================
+//                 ANALISI DI UNA PRESA DATI (senza ROOT)
+// =====================================================================
+//
+// AnalyzeTake riunisce lettura, decodifica e pairing di un file FIFO e
+// restituisce le coppie accettate. Con nThreads == 1 il file è letto a
+// blocchi (StreamPairs), altrimenti è caricato in memoria e diviso ai
+// reset (ForEachPairParallel, 0 = tutti i core). Le coppie sono le stesse.
+// Se spectra non è nullo ci vengono aggiunti i dt di tutte le coppie;
+// in parallelo ogni worker riempie la sua copia (ShardedHistogram).
+// AnalyzeTakePipelined fa lo stesso con gli stadi in pipeline
+// (Pipeline.h) e passa ogni coppia anche a una funzione dell'utente.
+// =====================================================================
+
+namespace mulife {
+
+struct TakeResult {
+    std::string               path;
+    std::vector<double>       dt_values;     // tempi di decadimento [µs]
+    std::vector<unsigned int> startBlocks;   // blocchi allo stop "immediato"
+    std::vector<unsigned int> stopBlocks;    // blocchi allo stop finale
+    PairingSummary            summary;
+};
+
+inline bool AnalyzeTake(const char* path, const PairingParams& params,
+                        TakeResult& res, int nThreads = 1,
+                        DecaySpectra* spectra = nullptr)
+{
+    res.path = path;
+    res.dt_values.clear();
+    res.startBlocks.clear();
+    res.stopBlocks.clear();
+    res.summary = PairingSummary();
+
+    auto collect = [&](const DecayPair& p) {
+        res.dt_values.push_back((double)p.dtTicks * params.tickUs);   // tick → µs
+        res.startBlocks.push_back(p.startBlocks);
+        res.stopBlocks.push_back(p.stopBlocks);
+    };
+
+    if (nThreads == 1) {
+        return StreamPairs(path, params, [&](const DecayPair& p) {
+            collect(p);
+            if (spectra != nullptr) spectra->Fill(res.dt_values.back(), p.stopBlocks);
+        }, &res.summary);
+    }
+
+    detail::StageClock::time_point t0 = detail::StageClock::now();
+    std::vector<unsigned int> CH;
+    std::vector<unsigned int> CT;
+    if (!LoadFifo(path, CH, CT)) return false;
+    const double readSec = detail::SecondsSince(t0);
+
+    unsigned int nt = (nThreads > 0) ? (unsigned int)nThreads : DefaultThreads();
+    DecaySpectra empty = (spectra != nullptr) ? *spectra : DecaySpectra();
+    empty.Reset();
+    ShardedHistogram<DecaySpectra> shards(nt, empty);
+
+    // coppie per blocco, poi unite nell'ordine sequenziale
+    std::vector<std::vector<DecayPair>> results(detail::TASKS_PER_THREAD * nt);
+    ForEachPairParallel(CH, CT, params,
+                        [&](const DecayPair& p, std::size_t task, unsigned int thread) {
+                            results[task].push_back(p);
+                            if (spectra != nullptr) {
+                                shards.Local(thread).Fill((double)p.dtTicks * params.tickUs,
+                                                          p.stopBlocks);
+                            }
+                        },
+                        &res.summary, nt);
+
+    t0 = detail::StageClock::now();
+    for (const std::vector<DecayPair>& r : results) {
+        for (const DecayPair& p : r) collect(p);
+    }
+    if (spectra != nullptr) spectra->Add(shards.Merge());
+    res.summary.times.read = readSec;
+    res.summary.times.sink += detail::SecondsSince(t0);
+    return true;
+}
+
+// Come AnalyzeTake in streaming, con lettura, decodifica e pairing su
+// thread separati; fill(dt, stopBlocks) viene chiamato nel thread
+// chiamante per ogni coppia, mentre gli altri stadi vanno avanti.
+template <class Fill>
+bool AnalyzeTakePipelined(const char* path, const PairingParams& params,
+                          TakeResult& res, Fill&& fill, PipelineStats* stats = nullptr)
+{
+    res.path = path;
+    res.dt_values.clear();
+    res.startBlocks.clear();
+    res.stopBlocks.clear();
+    res.summary = PairingSummary();
+
+    auto collect = [&](const DecayPair& p) {
+        double dt = (double)p.dtTicks * params.tickUs;   // tick → µs
+        res.dt_values.push_back(dt);
+        res.startBlocks.push_back(p.startBlocks);
+        res.stopBlocks.push_back(p.stopBlocks);
+        fill(dt, p.stopBlocks);
+    };
+    return PipelinePairs(path, params, collect, &res.summary, stats);
+}
+
+// File "FIFOread_*.txt" in una cartella, in ordine alfabetico
+inline std::vector<std::string> FindTakes(const char* dir, const char* prefix = "FIFOread_")
+{
+    namespace fs = std::filesystem;
+    std::vector<std::string> files;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(dir, ec)) {
+        const fs::path& p = entry.path();
+        if (p.extension() == ".txt" && p.filename().string().rfind(prefix, 0) == 0) {
+            files.push_back(p.string());
+        }
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+// "data/Take/FIFOread_Take8.txt" -> "Take8"
+inline std::string TakeLabel(const std::string& path, const char* prefix = "FIFOread_")
+{
+    std::string stem = std::filesystem::path(path).stem().string();
+    std::string pre(prefix);
+    if (stem.rfind(pre, 0) == 0) stem.erase(0, pre.size());
+    return stem;
+}
+
+} // namespace mulife
+
+#endif // MULIFE_TAKEANALYSIS_H
@@ -0,0 +1,330 @@
+#ifndef MULIFE_WAVEPULSES_H
+#define MULIFE_WAVEPULSES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "EventBitmaps.h"
+
+// =====================================================================
+//        RICERCA DEGLI IMPULSI NEI CAMPIONI WAVEDUMP (4 canali)
+// =====================================================================
+//
+// I campioni arrivano interlacciati, quattro canali per campione
+// (x[4*i + k], k = CH0 … CH3, come in WaveRecord). Per ogni canale, in
+// un solo passaggio:
+//
+//   baseline  : media mobile esponenziale, b += (x - b) / 2^baselineShift,
+//               partendo dal primo campione; è ferma durante un impulso;
+//   segnale   : s = b - x (impulsi negativi);
+//   inizio    : s > threshold, dopo i primi warmupSamples campioni;
+//               il tempo è l'attraversamento della soglia, interpolato
+//               linearmente tra il campione prima e quello dopo;
+//   fine      : s < threshold - hysteresis;
+//   impulso   : ampiezza (massimo di s), campione del massimo, area
+//               (somma di s sui campioni dell'impulso), baseline.
+//
+// I quattro canali sono elaborati insieme: in AVX2 un registro da 256
+// bit tiene lo stato di tutti e quattro (un intero a 64 bit per canale)
+// e ogni campione costa una manciata di istruzioni, senza salti; solo
+// all'inizio e alla fine di un impulso (rari) si passa al codice scalare
+// per i canali interessati. Senza AVX2 lo stesso calcolo è fatto canale
+// per canale.
+//
+// Tutta l'aritmetica è intera, con baseline e segnale in virgola fissa
+// (8 bit frazionari): le due versioni danno esattamente gli stessi
+// impulsi. La scelta AVX2 / scalare è fatta a runtime (vedi
+// EventBitmaps.h). baselineShift deve stare in [0, PULSE_MAX_SHIFT],
+// hysteresis e warmupSamples non possono essere negativi: PulseFinder
+// non elabora nulla con una configurazione non valida.
+// =====================================================================
+
+namespace mulife {
+
+const int PULSE_CHANNELS  = 4;
+const int PULSE_MAX_SHIFT = 30;   // baselineShift massimo
+
+struct PulseConfig {
+    int threshold      = 50;   // soglia di inizio [ADC]
+    int hysteresis     = 25;   // l'impulso finisce sotto threshold - hysteresis [ADC]
+    int baselineShift  = 6;    // peso della media mobile: 1/2^baselineShift
+    int warmupSamples  = 64;   // campioni iniziali solo per la baseline
+};
+
+// Shift fuori da [0, PULSE_MAX_SHIFT] non sono definiti in C++ e in AVX2
+// danno un altro risultato (0 per shift >= 64)
+inline bool ValidPulseConfig(const PulseConfig& c)
+{
+    return c.baselineShift >= 0 && c.baselineShift <= PULSE_MAX_SHIFT &&
+           c.hysteresis >= 0 && c.warmupSamples >= 0;
+}
+
+struct WaveHit {
+    int         channel   = 0;
+    double      time      = 0.0;     // attraversamento della soglia [campioni]
+    int         start     = 0;       // primo campione sopra soglia
+    int         peak      = 0;       // campione del massimo
+    int         length    = 0;       // campioni dell'impulso
+    double      amplitude = 0.0;     // [ADC]
+    double      area      = 0.0;     // [ADC × campioni]
+    double      baseline  = 0.0;     // [ADC]
+    bool        closed    = true;    // false: ancora sopra soglia a fine record
+};
+
+namespace detail {
+
+const int PULSE_FRAC = 8;   // bit frazionari della virgola fissa
+
+// Stato dei quattro canali: array da 4 interi a 64 bit, allineati per
+// caricarli in un registro AVX2
+struct alignas(32) PulseState {
+    std::int64_t base[PULSE_CHANNELS];      // baseline [ADC << 8]
+    std::int64_t prevSig[PULSE_CHANNELS];   // segnale del campione prima
+    std::int64_t inPulse[PULSE_CHANNELS];   // 0 o -1 (tutti i bit)
+    std::int64_t amp[PULSE_CHANNELS];
+    std::int64_t area[PULSE_CHANNELS];
+    std::int64_t peak[PULSE_CHANNELS];
+    double       time[PULSE_CHANNELS];
+    std::int64_t start[PULSE_CHANNELS];
+};
+
+// Floor di v / 2^k (shift aritmetico)
+inline std::int64_t ShiftRight(std::int64_t v, int k)
+{
+    return (v >= 0) ? (v >> k) : -((-v + ((std::int64_t)1 << k) - 1) >> k);
+}
+
+inline double CrossingTime(std::int64_t i, std::int64_t prevSig, std::int64_t sig, std::int64_t thr)
+{
+    if (i == 0 || sig == prevSig) return (double)i;
+    return (double)(i - 1) + (double)(thr - prevSig) / (double)(sig - prevSig);
+}
+
+inline void OpenPulse(PulseState& st, int k, std::int64_t i, std::int64_t sig, std::int64_t thr)
+{
+    st.inPulse[k] = -1;
+    st.amp[k]     = sig;
+    st.area[k]    = sig;
+    st.peak[k]    = i;
+    st.start[k]   = i;
+    st.time[k]    = CrossingTime(i, st.prevSig[k], sig, thr);
+}
+
+inline void ClosePulse(PulseState& st, int k, std::int64_t end, bool closed,
+                       std::vector<WaveHit>& out)
+{
+    const double scale = 1.0 / (double)(1 << PULSE_FRAC);
+    WaveHit h;
+    h.channel   = k;
+    h.time      = st.time[k];
+    h.start     = (int)st.start[k];
+    h.peak      = (int)st.peak[k];
+    h.length    = (int)(end - st.start[k]);
+    h.amplitude = (double)st.amp[k] * scale;
+    h.area      = (double)st.area[k] * scale;
+    h.baseline  = (double)st.base[k] * scale;
+    h.closed    = closed;
+    out.push_back(h);
+    st.inPulse[k] = 0;
+}
+
+// n campioni da x, il primo con indice i0 nel record, canale per canale
+inline void FindPulsesScalar(const std::int32_t* x, std::size_t n, std::size_t i0,
+                             const PulseConfig& c, PulseState& st, std::vector<WaveHit>& out)
+{
+    const std::int64_t thr    = (std::int64_t)c.threshold * (1 << PULSE_FRAC);
+    const std::int64_t thrEnd = (std::int64_t)(c.threshold - c.hysteresis) * (1 << PULSE_FRAC);
+
+    for (std::size_t j = 0; j < n; ++j) {
+        const std::size_t i = i0 + j;
+        const bool armed = i >= (std::size_t)c.warmupSamples;
+        for (int k = 0; k < PULSE_CHANNELS; ++k) {
+            const std::int64_t xs  = (std::int64_t)x[PULSE_CHANNELS * j + k] * (1 << PULSE_FRAC);
+            const std::int64_t sig = st.base[k] - xs;
+
+            if (st.inPulse[k] != 0) {
+                if (sig < thrEnd) {
+                    ClosePulse(st, k, (std::int64_t)i, true, out);
+                } else {
+                    st.area[k] += sig;
+                    if (sig > st.amp[k]) {
+                        st.amp[k]  = sig;
+                        st.peak[k] = (std::int64_t)i;
+                    }
+                }
+            } else if (armed && sig > thr) {
+                OpenPulse(st, k, (std::int64_t)i, sig, thr);
+            }
+            if (st.inPulse[k] == 0) st.base[k] += ShiftRight(xs - st.base[k], c.baselineShift);
+            st.prevSig[k] = sig;
+        }
+    }
+}
+
+#if defined(MULIFE_AVX2_DISPATCH)
+
+// v >> k aritmetico su interi a 64 bit (AVX2 ha solo lo shift logico):
+// con un offset di 2^62 i valori diventano positivi
+__attribute__((target("avx2")))
+inline __m256i ShiftRightEpi64(__m256i v, int k)
+{
+    const __m256i bias = _mm256_set1_epi64x((std::int64_t)1 << 62);
+    __m256i u = _mm256_srli_epi64(_mm256_add_epi64(v, bias), k);
+    return _mm256_sub_epi64(u, _mm256_set1_epi64x(((std::int64_t)1 << 62) >> k));
+}
+
+__attribute__((target("avx2")))
+inline void LoadPulseState(const PulseState& st, __m256i& base, __m256i& prevSig, __m256i& inP,
+                           __m256i& amp, __m256i& area, __m256i& peak)
+{
+    base    = _mm256_load_si256(reinterpret_cast<const __m256i*>(st.base));
+    prevSig = _mm256_load_si256(reinterpret_cast<const __m256i*>(st.prevSig));
+    inP     = _mm256_load_si256(reinterpret_cast<const __m256i*>(st.inPulse));
+    amp     = _mm256_load_si256(reinterpret_cast<const __m256i*>(st.amp));
+    area    = _mm256_load_si256(reinterpret_cast<const __m256i*>(st.area));
+    peak    = _mm256_load_si256(reinterpret_cast<const __m256i*>(st.peak));
+}
+
+__attribute__((target("avx2")))
+inline void StorePulseState(PulseState& st, __m256i base, __m256i prevSig, __m256i inP,
+                            __m256i amp, __m256i area, __m256i peak)
+{
+    _mm256_store_si256(reinterpret_cast<__m256i*>(st.base), base);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(st.prevSig), prevSig);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(st.inPulse), inP);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(st.amp), amp);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(st.area), area);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(st.peak), peak);
+}
+
+__attribute__((target("avx2")))
+inline void FindPulsesAVX2(const std::int32_t* x, std::size_t n, std::size_t i0,
+                           const PulseConfig& c, PulseState& st, std::vector<WaveHit>& out)
+{
+    const std::int64_t thrS    = (std::int64_t)c.threshold * (1 << PULSE_FRAC);
+    const __m256i      thr     = _mm256_set1_epi64x(thrS);
+    const __m256i      thrEnd  = _mm256_set1_epi64x((std::int64_t)(c.threshold - c.hysteresis) * (1 << PULSE_FRAC));
+    const __m256i      ones    = _mm256_set1_epi64x(-1);
+    const int          shift   = c.baselineShift;
+
+    __m256i base, prevSig, inP, amp, area, peak;
+    LoadPulseState(st, base, prevSig, inP, amp, area, peak);
+
+    for (std::size_t j = 0; j < n; ++j) {
+        const std::size_t i = i0 + j;
+        const __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + PULSE_CHANNELS * j));
+        const __m256i xs  = _mm256_slli_epi64(_mm256_cvtepi32_epi64(raw), PULSE_FRAC);
+        const __m256i sig = _mm256_sub_epi64(base, xs);
+        const __m256i idx = _mm256_set1_epi64x((std::int64_t)i);
+
+        // fine (dentro e sotto la soglia bassa) e inizio (fuori e sopra soglia)
+        const __m256i below = _mm256_cmpgt_epi64(thrEnd, sig);
+        const __m256i end   = _mm256_and_si256(inP, below);
+        __m256i       begin = _mm256_andnot_si256(inP, _mm256_cmpgt_epi64(sig, thr));
+        if (i < (std::size_t)c.warmupSamples) begin = _mm256_setzero_si256();
+
+        if (!_mm256_testz_si256(_mm256_or_si256(end, begin), ones)) {
+            // caso raro: aggiornamento canale per canale, come nello scalare
+            StorePulseState(st, base, prevSig, inP, amp, area, peak);
+            FindPulsesScalar(x + PULSE_CHANNELS * j, 1, i, c, st, out);
+            LoadPulseState(st, base, prevSig, inP, amp, area, peak);
+            continue;
+        }
+
+        // dentro un impulso: area e massimo
+        const __m256i newMax = _mm256_and_si256(inP, _mm256_cmpgt_epi64(sig, amp));
+        area = _mm256_add_epi64(area, _mm256_and_si256(inP, sig));
+        amp  = _mm256_blendv_epi8(amp, sig, newMax);
+        peak = _mm256_blendv_epi8(peak, idx, newMax);
+
+        // fuori: baseline
+        const __m256i step = ShiftRightEpi64(_mm256_sub_epi64(xs, base), shift);
+        base    = _mm256_add_epi64(base, _mm256_andnot_si256(inP, step));
+        prevSig = sig;
+    }
+    StorePulseState(st, base, prevSig, inP, amp, area, peak);
+}
+
+inline bool UsePulsesAVX2()
+{
+    return CpuHasAVX2();
+}
+
+#endif // MULIFE_AVX2_DISPATCH
+
+} // namespace detail
+
+// Ricerca degli impulsi in un flusso di campioni, anche a blocchi: lo
+// stato (baseline, impulsi aperti) resta tra una chiamata e l'altra.
+// Gli indici dei campioni contano dall'ultimo Reset().
+class PulseFinder {
+public:
+    explicit PulseFinder(const PulseConfig& config = PulseConfig(), bool useSimd = true)
+        : config_(config), useSimd_(useSimd), valid_(ValidPulseConfig(config)) { Reset(); }
+
+    // false se la configurazione non è valida (Process non fa nulla)
+    bool Valid() const { return valid_; }
+
+    // Nuovo record: baseline dal prossimo campione, indici da 0
+    void Reset()
+    {
+        state_ = detail::PulseState();
+        next_  = 0;
+    }
+
+    // n campioni interlacciati (4 canali ciascuno); accoda in out gli
+    // impulsi che si chiudono
+    void Process(const std::int32_t* x, std::size_t n, std::vector<WaveHit>& out)
+    {
+        if (n == 0 || !valid_) return;
+        if (next_ == 0) {
+            for (int k = 0; k < PULSE_CHANNELS; ++k) {
+                state_.base[k] = (std::int64_t)x[k] * (1 << detail::PULSE_FRAC);
+            }
+        }
+#if defined(MULIFE_AVX2_DISPATCH)
+        if (useSimd_ && detail::UsePulsesAVX2()) {
+            detail::FindPulsesAVX2(x, n, next_, config_, state_, out);
+        } else {
+            detail::FindPulsesScalar(x, n, next_, config_, state_, out);
+        }
+#else
+        detail::FindPulsesScalar(x, n, next_, config_, state_, out);
+#endif
+        next_ += n;
+    }
+
+    // Fine del record: chiude gli impulsi ancora aperti (closed = false)
+    void Finish(std::vector<WaveHit>& out)
+    {
+        for (int k = 0; k < PULSE_CHANNELS; ++k) {
+            if (state_.inPulse[k] != 0) detail::ClosePulse(state_, k, (std::int64_t)next_, false, out);
+        }
+    }
+
+    const PulseConfig& Config() const { return config_; }
+
+private:
+    PulseConfig        config_;
+    bool               useSimd_;
+    bool               valid_;
+    detail::PulseState state_;
+    std::size_t        next_ = 0;
+};
+
+// Tutti gli impulsi di un record di n campioni interlacciati; false se
+// la configurazione non è valida
+inline bool FindWavePulses(const std::int32_t* x, std::size_t n, const PulseConfig& config,
+                           std::vector<WaveHit>& out, bool useSimd = true)
+{
+    PulseFinder finder(config, useSimd);
+    if (!finder.Valid()) return false;
+    finder.Process(x, n, out);
+    finder.Finish(out);
+    return true;
+}
+
+} // namespace mulife
+
+#endif // MULIFE_WAVEPULSES_H
@@ -0,0 +1,418 @@
+#ifndef MULIFE_WAVEDUMPSPECTRUM_H
+#define MULIFE_WAVEDUMPSPECTRUM_H
+
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "FifoReader.h"
+#include "Histogram.h"
+#include "Parallel.h"
+#include "WavePulses.h"
+
+// =====================================================================
+//            SPETTRI IN AMPIEZZA DAI FILE WAVEDUMP (4 canali)
+// =====================================================================
+//
+// Per la misura della massa (parte V del logbook) l'uscita
+// dell'integratore dei PMT del blocco va all'ADC:
+//
+//   CH0 PMT08, CH1 PMT09, CH2 PMT10, CH3 PMT11
+//
+// I file esportati da wavedump (ad es. data/wavedump/PlotData.txt) hanno
+// una riga per campione: indice del campione e i quattro canali ADC,
+// separati da tab. Un nuovo evento (record) comincia quando l'indice
+// riparte (non cresce rispetto alla riga prima); righe con meno di
+// quattro canali o non numeriche sono ignorate.
+//
+// Per ogni record e canale (impulsi negativi rispetto alla baseline):
+//   baseline  : media dei primi baselineSamples campioni;
+//   ampiezza  : baseline - minimo nel gate;
+//   area      : somma di (baseline - campione) nel gate [gateStart, gateEnd);
+//   picco     : indice del minimo.
+// Con findPulses = true si usa invece la ricerca degli impulsi di
+// WavePulses.h (baseline mobile, soglia con isteresi): per ogni canale
+// conta l'impulso più ampio del record.
+// Il canale è colpito se l'ampiezza supera threshold. Gli spettri per
+// canale contengono i soli canali colpiti; quelli "somma" la somma sui
+// canali colpiti dello stesso record (l'energia depositata nel blocco).
+//
+// Il file è letto record per record: in memoria c'è un solo record (un
+// array di campioni riusato), quindi anche acquisizioni da molti GB
+// girano con memoria limitata. I campioni sono interlacciati, i quattro
+// canali di un campione uno accanto all'altro: un registro vettoriale
+// contiene un campione di tutti i canali, sia nelle riduzioni del gate
+// (somma, minimo) sia in WavePulses.h. Più file vanno in parallelo, uno
+// per task, ciascun thread con la sua copia degli spettri
+// (ShardedHistogram).
+// =====================================================================
+
+namespace mulife {
+
+const int WAVE_CHANNELS = 4;
+
+struct WaveConfig {
+    int         baselineSamples  = 64;         // campioni iniziali per la baseline
+    int         gateStart        = -1;         // inizio del gate (-1 = dopo la baseline)
+    int         gateEnd          = -1;         // fine del gate, esclusa (-1 = fine del record)
+    double      threshold        = 50.0;       // ampiezza minima di un canale colpito [ADC]
+    int         ampBins          = 1024;
+    double      ampMax           = 16384.0;    // [ADC]
+    int         areaBins         = 1000;
+    double      areaMax          = 1e7;        // [ADC × campioni]
+    std::size_t maxRecordSamples = (std::size_t)1 << 20;   // oltre, i campioni sono scartati
+    bool        findPulses       = false;      // ricerca degli impulsi invece del gate
+    PulseConfig pulses;                        // parametri di WavePulses.h (soglia = threshold)
+};
+
+// Un record: campioni interlacciati, samples[4*i + k] = canale k del campione i
+struct WaveRecord {
+    std::vector<std::int32_t> samples;
+    std::uint64_t             dropped = 0;   // campioni oltre maxRecordSamples
+
+    std::size_t size() const { return samples.size() / WAVE_CHANNELS; }
+
+    std::int32_t at(std::size_t i, int k) const { return samples[WAVE_CHANNELS * i + (std::size_t)k]; }
+
+    void clear()
+    {
+        samples.clear();
+        dropped = 0;
+    }
+};
+
+struct WavePulse {
+    double baseline  = 0.0;   // [ADC]
+    double amplitude = 0.0;   // [ADC]
+    double area      = 0.0;   // [ADC × campioni]
+    int    peak      = -1;    // indice del minimo
+    bool   hit       = false;
+};
+
+struct WaveSpectra {
+    FixedHistogram amp[WAVE_CHANNELS];
+    FixedHistogram area[WAVE_CHANNELS];
+    FixedHistogram sumAmp;
+    FixedHistogram sumArea;
+    std::uint64_t  records = 0;
+    std::uint64_t  hits[WAVE_CHANNELS] = {0, 0, 0, 0};
+
+    WaveSpectra() = default;
+
+    explicit WaveSpectra(const WaveConfig& c)
+        : sumAmp(c.ampBins, 0.0, WAVE_CHANNELS * c.ampMax),
+          sumArea(c.areaBins, 0.0, WAVE_CHANNELS * c.areaMax)
+    {
+        for (int k = 0; k < WAVE_CHANNELS; ++k) {
+            amp[k]  = FixedHistogram(c.ampBins, 0.0, c.ampMax);
+            area[k] = FixedHistogram(c.areaBins, 0.0, c.areaMax);
+        }
+    }
+
+    void Fill(const WavePulse pulses[WAVE_CHANNELS])
+    {
+        ++records;
+        double a = 0.0, s = 0.0;
+        bool any = false;
+        for (int k = 0; k < WAVE_CHANNELS; ++k) {
+            if (!pulses[k].hit) continue;
+            ++hits[k];
+            amp[k].Fill(pulses[k].amplitude);
+            area[k].Fill(pulses[k].area);
+            a  += pulses[k].amplitude;
+            s  += pulses[k].area;
+            any = true;
+        }
+        if (any) {
+            sumAmp.Fill(a);
+            sumArea.Fill(s);
+        }
+    }
+
+    void Add(const WaveSpectra& o)
+    {
+        for (int k = 0; k < WAVE_CHANNELS; ++k) {
+            amp[k].Add(o.amp[k]);
+            area[k].Add(o.area[k]);
+            hits[k] += o.hits[k];
+        }
+        sumAmp.Add(o.sumAmp);
+        sumArea.Add(o.sumArea);
+        records += o.records;
+    }
+};
+
+// Parametri di WavePulses.h usati con findPulses: soglia e campioni
+// iniziali vengono dalla configurazione degli spettri
+inline PulseConfig WavePulseConfig(const WaveConfig& c)
+{
+    PulseConfig pc = c.pulses;
+    pc.threshold     = (int)c.threshold;
+    pc.warmupSamples = c.baselineSamples;
+    return pc;
+}
+
+// Almeno un campione per la baseline; parametri degli impulsi validi
+inline bool ValidWaveConfig(const WaveConfig& c)
+{
+    if (c.baselineSamples <= 0) return false;
+    return !c.findPulses || ValidPulseConfig(WavePulseConfig(c));
+}
+
+// Baseline, ampiezza, area e picco dei quattro canali di un record (gate)
+inline void AnalyzeWaveGate(const WaveRecord& rec, const WaveConfig& c,
+                            WavePulse out[WAVE_CHANNELS])
+{
+    const std::size_t n  = rec.size();
+    const std::size_t nb = std::min<std::size_t>((std::size_t)std::max(c.baselineSamples, 1), n);
+    const std::size_t g0 = std::min<std::size_t>((c.gateStart >= 0) ? (std::size_t)c.gateStart : nb, n);
+    const std::size_t g1 = (c.gateEnd >= 0) ? std::min<std::size_t>((std::size_t)c.gateEnd, n) : n;
+
+    for (int k = 0; k < WAVE_CHANNELS; ++k) out[k] = WavePulse();
+    if (nb == 0) return;
+    const std::int32_t* s = rec.samples.data();
+
+    // un campione (quattro canali) per iterazione
+    std::int64_t sum[WAVE_CHANNELS] = {0, 0, 0, 0};
+    for (std::size_t i = 0; i < nb; ++i) {
+        for (int k = 0; k < WAVE_CHANNELS; ++k) sum[k] += s[WAVE_CHANNELS * i + k];
+    }
+    for (int k = 0; k < WAVE_CHANNELS; ++k) out[k].baseline = (double)sum[k] / (double)nb;
+    if (g1 <= g0) return;
+
+    std::int32_t mn[WAVE_CHANNELS]   = {INT_MAX, INT_MAX, INT_MAX, INT_MAX};
+    std::int64_t gate[WAVE_CHANNELS] = {0, 0, 0, 0};
+    for (std::size_t i = g0; i < g1; ++i) {
+        for (int k = 0; k < WAVE_CHANNELS; ++k) {
+            mn[k]    = std::min(mn[k], s[WAVE_CHANNELS * i + k]);
+            gate[k] += s[WAVE_CHANNELS * i + k];
+        }
+    }
+
+    for (int k = 0; k < WAVE_CHANNELS; ++k) {
+        WavePulse& p = out[k];
+        std::size_t peak = g0;
+        while (rec.at(peak, k) != mn[k]) ++peak;
+
+        p.amplitude = p.baseline - (double)mn[k];
+        p.area      = p.baseline * (double)(g1 - g0) - (double)gate[k];
+        p.peak      = (int)peak;
+        p.hit       = p.amplitude > c.threshold;
+    }
+}
+
+// Come sopra, con l'impulso più ampio di ogni canale (WavePulses.h).
+// hits è un vettore di appoggio, riusato tra un record e l'altro.
+inline void AnalyzeWavePulses(const WaveRecord& rec, const WaveConfig& c,
+                              WavePulse out[WAVE_CHANNELS], std::vector<WaveHit>& hits)
+{
+    hits.clear();
+    FindWavePulses(rec.samples.data(), rec.size(), WavePulseConfig(c), hits);
+
+    for (int k = 0; k < WAVE_CHANNELS; ++k) out[k] = WavePulse();
+    for (const WaveHit& h : hits) {
+        WavePulse& p = out[h.channel];
+        if (p.hit && h.amplitude <= p.amplitude) continue;
+        p.baseline  = h.baseline;
+        p.amplitude = h.amplitude;
+        p.area      = h.area;
+        p.peak      = h.peak;
+        p.hit       = true;
+    }
+}
+
+inline void AnalyzeWaveRecord(const WaveRecord& rec, const WaveConfig& c,
+                              WavePulse out[WAVE_CHANNELS], std::vector<WaveHit>& hits)
+{
+    if (c.findPulses) {
+        AnalyzeWavePulses(rec, c, out, hits);
+    } else {
+        AnalyzeWaveGate(rec, c, out);
+    }
+}
+
+namespace detail {
+
+inline const char* SkipBlanks(const char* p, const char* end)
+{
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) ++p;
+    return p;
+}
+
+} // namespace detail
+
+// Lettura a record di un file wavedump (mappato, letto in avanti)
+class WavedumpReader {
+public:
+    explicit WavedumpReader(std::size_t maxRecordSamples = (std::size_t)1 << 20)
+        : maxSamples_(maxRecordSamples) {}
+
+    bool Open(const char* path)
+    {
+        if (!file_.Open(path)) return false;
+        pos_     = file_.Data();
+        end_     = file_.Data() + file_.Size();
+        pending_ = false;
+        rows_    = 0;
+        return true;
+    }
+
+    // Prossimo record in rec; false a fine file
+    bool Next(WaveRecord& rec)
+    {
+        rec.clear();
+        std::uint64_t prev = 0;
+
+        if (pending_) {
+            Append(rec, row_);
+            prev     = row_[0];
+            pending_ = false;
+        }
+        while (ReadRow(row_)) {
+            if (rec.size() + rec.dropped > 0 && row_[0] <= prev) {
+                pending_ = true;   // primo campione del record successivo
+                return true;
+            }
+            Append(rec, row_);
+            prev = row_[0];
+        }
+        return rec.size() + rec.dropped > 0;
+    }
+
+    // Righe con quattro canali lette finora
+    std::uint64_t Rows() const { return rows_; }
+
+private:
+    // Prossima riga con indice e quattro canali; le altre sono saltate
+    bool ReadRow(std::uint64_t v[1 + WAVE_CHANNELS])
+    {
+        while (pos_ < end_) {
+            const char* p = pos_;
+            int n = 0;
+            for (; n < 1 + WAVE_CHANNELS; ++n) {
+                p = detail::SkipBlanks(p, end_);
+                const char* q = detail::ParseUInt(p, end_, v[n]);
+                if (q == nullptr) break;
+                p = q;
+            }
+            const char* eol = static_cast<const char*>(std::memchr(p, '\n', (std::size_t)(end_ - p)));
+            pos_ = (eol != nullptr) ? eol + 1 : end_;
+            if (n == 1 + WAVE_CHANNELS) {
+                ++rows_;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void Append(WaveRecord& rec, const std::uint64_t v[1 + WAVE_CHANNELS]) const
+    {
+        if (rec.size() >= maxSamples_) {
+            ++rec.dropped;
+            return;
+        }
+        for (int k = 0; k < WAVE_CHANNELS; ++k) rec.samples.push_back((std::int32_t)v[1 + k]);
+    }
+
+    MappedFile    file_;
+    const char*   pos_ = nullptr;
+    const char*   end_ = nullptr;
+    std::size_t   maxSamples_;
+    std::uint64_t row_[1 + WAVE_CHANNELS] = {0, 0, 0, 0, 0};
+    bool          pending_ = false;
+    std::uint64_t rows_    = 0;
+};
+
+// Spettri di un file, record per record. sink(const WavePulse[4],
+// record) è chiamato per ogni record, dopo il riempimento degli spettri.
+// Ritorna false se il file non può essere aperto.
+template <class Sink>
+bool AnalyzeWavedumpFile(const char* path, const WaveConfig& config,
+                         WaveSpectra& spectra, Sink&& sink, std::uint64_t* rows = nullptr)
+{
+    WavedumpReader in(config.maxRecordSamples);
+    if (!in.Open(path)) return false;
+
+    WaveRecord           rec;
+    WavePulse            pulses[WAVE_CHANNELS];
+    std::vector<WaveHit> hits;
+    std::uint64_t        k = 0;
+    while (in.Next(rec)) {
+        AnalyzeWaveRecord(rec, config, pulses, hits);
+        spectra.Fill(pulses);
+        sink(static_cast<const WavePulse*>(pulses), k++);
+    }
+    if (rows != nullptr) *rows = in.Rows();
+    return true;
+}
+
+inline bool AnalyzeWavedumpFile(const char* path, const WaveConfig& config,
+                                WaveSpectra& spectra, std::uint64_t* rows = nullptr)
+{
+    return AnalyzeWavedumpFile(path, config, spectra,
+                               [](const WavePulse*, std::uint64_t) {}, rows);
+}
+
+struct WaveInfo {
+    std::size_t   files  = 0;
+    std::size_t   failed = 0;   // file che non si aprono
+    std::uint64_t rows   = 0;
+};
+
+// Spettri di più file, in parallelo (un file per task, nThreads = 0:
+// tutti i core). I conteggi non dipendono dal numero di thread.
+// Ritorna false, senza leggere i file, se la configurazione non è
+// valida (ValidWaveConfig).
+inline bool AnalyzeWavedump(const std::vector<std::string>& files, const WaveConfig& config,
+                            WaveSpectra& out, unsigned int nThreads = 0,
+                            WaveInfo* info = nullptr)
+{
+    if (!ValidWaveConfig(config)) return false;
+    if (nThreads == 0) nThreads = DefaultThreads();
+
+    ShardedHistogram<WaveSpectra> shards(nThreads, WaveSpectra(config));
+    std::vector<std::uint64_t>    rows(files.size(), 0);
+    std::vector<char>             ok(files.size(), 0);
+
+    ParallelFor(files.size(), nThreads, [&](std::size_t f, unsigned int thread) {
+        ok[f] = AnalyzeWavedumpFile(files[f].c_str(), config, shards.Local(thread), &rows[f]) ? 1 : 0;
+    });
+
+    out = shards.Merge();
+
+    WaveInfo s;
+    s.files = files.size();
+    for (std::size_t f = 0; f < files.size(); ++f) {
+        s.rows   += rows[f];
+        s.failed += ok[f] ? 0u : 1u;
+    }
+    if (info != nullptr) *info = s;
+    return true;
+}
+
+// Tabella riassuntiva: canali colpiti, ampiezza e area medie
+inline void WriteWaveSummary(std::ostream& os, const WaveSpectra& sp)
+{
+    static const char* const pmt[WAVE_CHANNELS] = {"PMT08", "PMT09", "PMT10", "PMT11"};
+    char line[128];
+    os << "Record: " << sp.records << "\n";
+    os << "  canale          colpiti   <ampiezza> [ADC]      <area> [ADC×camp.]\n";
+    for (int k = 0; k < WAVE_CHANNELS; ++k) {
+        std::snprintf(line, sizeof(line), "  CH%d %-8s %12llu %18.1f %22.1f\n", k, pmt[k],
+                      (unsigned long long)sp.hits[k], sp.amp[k].Mean(), sp.area[k].Mean());
+        os << line;
+    }
+    std::snprintf(line, sizeof(line), "  somma        %12llu %18.1f %22.1f\n",
+                  (unsigned long long)sp.sumAmp.Entries(), sp.sumAmp.Mean(), sp.sumArea.Mean());
+    os << line;
+}
+
+} // namespace mulife
+
+#endif // MULIFE_WAVEDUMPSPECTRUM_H
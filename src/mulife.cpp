@@ -0,0 +1,648 @@
+// =====================================================================
+//                 MULIFE: ESEGUIBILE COMPILATO (senza Cling)
+// =====================================================================
+//
+// Stesse analisi delle macro, compilate con CMake (vedi CMakeLists.txt):
+//
+//   mulife lifetime    <file> [--nbins 80] [--tmin 0] [--tmax 20]
+//                             [--threads 1] [--pipeline] [--out Mu_life_new.root]
+//                             [--stats Mu_life_new.json] [--calib ClockCalibration.txt]
+//   mulife scan        <file|cartella> [--early 10] [--final 20] [--ebw 2] [--fbw 3]
+//                             [--tmin 0] [--tmax 20] [--threads 0] [--csv scan.csv]
+//                             [--calib ClockCalibration.txt]
+//   mulife decaytime   <file> [--out DecayTime.root] [--calib ClockCalibration.txt]
+//   mulife calibration <file> [--out Calibration.root] [--window 32]
+//                             [--calib ClockCalibration.txt]
+//   mulife delay       <file> [--out Delay.root]
+//   mulife skew        <file> [--window 16] [--out Skew.root]
+//   mulife spectrum    <file|cartella> [--baseline 64] [--threshold 50]
+//                             [--pulses] [--hysteresis 25] [--shift 6]
+//                             [--threads 0] [--out Spectrum.root]
+//   mulife generate    <file> [--rows 10000000] [--tau 2.197] [--rate 0.1]
+//                             [--decay 0.5] [--accstart 0.6] [--accstop 0.2]
+//                             [--seed 1] [--binary] [--check]
+//
+// lifetime     : pairing START → STOP, istogrammi e fit unbinned (Mu_life_new)
+// scan         : pairing e fit unbinned su una griglia di parametri, con
+//                i file letti una volta sola (ParameterScan.h); ogni
+//                opzione accetta "v", "v1,v2,…" o "inizio:fine:passo"
+// decaytime    : primo STOP dopo ogni START, senza finestre (DecayTime.cpp)
+// calibration  : costante di calibrazione del clock (Calibration in DEONANO.cpp),
+//                con la deriva su finestre di --window periodi; scrive il
+//                file --calib, letto poi da lifetime, scan e decaytime (se il
+//                file non c'è si usa il tick nominale, dall'header dei
+//                file binari o 5 ns)
+// delay        : ritardo tra i canali 2 e 1 (Delay in DEONANO.cpp)
+// skew         : ritardi tra tutte le coppie di bit START, STOP, PMT8–11
+//                entro ±--window tick (ChannelSkew.h)
+// spectrum     : spettri in ampiezza e area dell'integratore (PMT08–11)
+//                dai file wavedump, in parallelo sui file (WavedumpSpectrum.h);
+//                con --pulses dall'impulso più ampio di ogni canale
+//                (baseline mobile con peso 1/2^--shift e soglia con
+//                isteresi, WavePulses.h)
+// generate     : flusso FIFO sintetico con tau noto (SyntheticFifo.h);
+//                con --check il file viene poi analizzato e il tau
+//                ricostruito confrontato con quello iniettato
+//
+// Tutto il calcolo usa il core senza ROOT (MuLife.h). ROOT serve solo
+// per scrivere gli istogrammi (e il fit binned) nel file --out, tramite
+// RootSink.h: se il progetto è compilato senza ROOT i risultati sono
+// solo stampati.
+// =====================================================================
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "MuLife.h"
+
+#if defined(MULIFE_WITH_ROOT)
+#include "RootSink.h"
+#endif
+
+using namespace mulife;
+
+namespace {
+
+// Opzioni "--nome valore" e "--flag" dopo il file
+struct Options {
+    std::map<std::string, std::string> values;
+
+    bool Has(const char* name) const { return values.count(name) != 0; }
+
+    std::string Get(const char* name, const char* def) const
+    {
+        auto it = values.find(name);
+        return (it != values.end()) ? it->second : std::string(def);
+    }
+
+    double GetDouble(const char* name, double def) const
+    {
+        auto it = values.find(name);
+        return (it != values.end()) ? std::atof(it->second.c_str()) : def;
+    }
+
+    int GetInt(const char* name, int def) const
+    {
+        auto it = values.find(name);
+        return (it != values.end()) ? std::atoi(it->second.c_str()) : def;
+    }
+};
+
+bool ParseOptions(int argc, char** argv, int first, Options& opt)
+{
+    for (int k = first; k < argc; ++k) {
+        if (std::strncmp(argv[k], "--", 2) != 0) {
+            std::cerr << "[ERRORE] Argomento non riconosciuto: " << argv[k] << "\n";
+            return false;
+        }
+        std::string name = argv[k] + 2;
+        if (k + 1 < argc && std::strncmp(argv[k + 1], "--", 2) != 0) {
+            opt.values[name] = argv[++k];
+        } else {
+            opt.values[name] = "1";
+        }
+    }
+    return true;
+}
+
+void Usage()
+{
+    std::cerr << "Uso:\n"
+              << "  mulife lifetime    <file> [--nbins 80] [--tmin 0] [--tmax 20]\n"
+              << "                            [--threads 1] [--pipeline] [--out Mu_life_new.root]\n"
+              << "                            [--stats Mu_life_new.json] [--calib ClockCalibration.txt]\n"
+              << "  mulife scan        <file|cartella> [--early 10] [--final 20] [--ebw 2] [--fbw 3]\n"
+              << "                            [--tmin 0] [--tmax 20] [--threads 0] [--csv scan.csv]\n"
+              << "                            [--calib ClockCalibration.txt]\n"
+              << "  mulife decaytime   <file> [--out DecayTime.root] [--calib ClockCalibration.txt]\n"
+              << "  mulife calibration <file> [--out Calibration.root] [--window 32]\n"
+              << "                            [--calib ClockCalibration.txt]\n"
+              << "  mulife delay       <file> [--out Delay.root]\n"
+              << "  mulife skew        <file> [--window 16] [--out Skew.root]\n"
+              << "  mulife spectrum    <file|cartella> [--baseline 64] [--threshold 50]\n"
+              << "                            [--pulses] [--hysteresis 25] [--shift 6]\n"
+              << "                            [--threads 0] [--out Spectrum.root]\n"
+              << "  mulife generate    <file> [--rows 10000000] [--tau 2.197] [--rate 0.1]\n"
+              << "                            [--decay 0.5] [--accstart 0.6] [--accstop 0.2]\n"
+              << "                            [--seed 1] [--binary] [--check]\n";
+}
+
+// Tick nominale delle prese: quello dell'header dei file binari
+// (FifoBinary.h), se è lo stesso per tutti, altrimenti 5 ns
+double NominalTick(const std::vector<std::string>& files)
+{
+    double tick = tick_us;
+    FifoHeaderTickUs(files, tick);
+    return tick;
+}
+
+// Tick [µs] dal file di calibrazione --calib (di default
+// ClockCalibration.txt, se esiste), altrimenti fallback. Ritorna false
+// solo se un file indicato esplicitamente non si può leggere.
+bool TickFromOptions(const Options& opt, double fallback, double& tickUs)
+{
+    const std::string path = opt.Get("calib", CLOCK_CALIBRATION_FILE);
+    if (LoadTickUs(path.c_str(), tickUs)) {
+        std::cout << "[INFO] Tick da " << path << ": " << tickUs << " µs\n";
+        return true;
+    }
+    tickUs = fallback;
+    if (opt.Has("calib")) {
+        std::cerr << "[ERRORE] File di calibrazione non valido: " << path << "\n";
+        return false;
+    }
+    std::cout << "[INFO] Nessun file di calibrazione, tick nominale " << tickUs << " µs\n";
+    return true;
+}
+
+// ---------------------------------------------------------------------
+//                              lifetime
+// ---------------------------------------------------------------------
+int RunLifetime(const char* filename, const Options& opt)
+{
+    const int    nbins = opt.GetInt("nbins", 80);
+    const double tmin  = opt.GetDouble("tmin", 0.0);
+    const double tmax  = opt.GetDouble("tmax", 20.0);
+
+    if (nbins <= 0 || !(tmax > tmin)) {
+        std::cerr << "[ERRORE] Binning non valido: " << nbins << " bin in ["
+                  << tmin << ", " << tmax << "]\n";
+        return 1;
+    }
+
+    LifetimeConfig config;
+    config.params.tmin = tmin;
+    config.params.tmax = tmax;
+    config.nbins    = nbins;
+    config.nThreads = opt.GetInt("threads", 1);
+    config.pipeline = opt.Has("pipeline");
+    if (!TickFromOptions(opt, NominalTick({filename}), config.params.tickUs)) return 1;
+
+    LifetimeReport rep;
+    if (!AnalyzeLifetime(filename, config, rep)) {
+        std::cerr << "[ERRORE] Impossibile aprire il file " << filename << "\n";
+        return 1;
+    }
+
+    const TakeResult&   take    = rep.take;
+    const DecaySpectra& spectra = rep.spectra;
+    if (take.summary.rows == 0) {
+        std::cerr << "[ERRORE] File vuoto o colonne di lunghezza diversa.\n";
+        return 1;
+    }
+
+    std::cout << "[INFO] Righe lette: " << take.summary.rows << "\n";
+    std::cout << "[INFO] Eventi dopo il primo reset: " << take.summary.events << "\n";
+    std::cout << "[INFO] Coppie START–STOP accettate: " << take.dt_values.size() << "\n";
+    std::cout << "[INFO] Entries istogramma totale: " << spectra.all.Entries() << "\n";
+    std::cout << "[INFO] Entries istogramma PMT8:  " << spectra.pmt[0].Entries() << "\n";
+    std::cout << "[INFO] Entries istogramma PMT9:  " << spectra.pmt[1].Entries() << "\n";
+    std::cout << "[INFO] Entries istogramma PMT10: " << spectra.pmt[2].Entries() << "\n";
+    std::cout << "[INFO] Entries istogramma PMT11: " << spectra.pmt[3].Entries() << "\n";
+    WriteStartOutcomes(std::cout, take.summary);
+
+    // riepilogo JSON (conteggi, scarti, tempi, fit) per il monitoraggio
+    if (opt.Has("stats")) {
+        std::string stats = opt.Get("stats", "Mu_life_new.json");
+        if (!SaveLifetimeJson(stats.c_str(), config, rep)) {
+            std::cerr << "[ERRORE] Impossibile scrivere il file " << stats << "\n";
+            return 1;
+        }
+        std::cout << "[INFO] Riepilogo salvato in " << stats << "\n";
+    }
+
+    if (take.dt_values.empty()) {
+        std::cerr << "[ATTENZIONE] Nessun dt ricostruito: controllare logica o parametri.\n";
+        return 1;
+    }
+
+    const LifetimeFitResult& ml = rep.ml;
+    if (rep.mlOk) {
+        std::cout << "\n============ FIT UNBINNED (max likelihood) ============\n";
+        std::cout << "Tau (µ)      = " << ml.tau << " ± " << ml.tauErr << " µs\n";
+        std::cout << "Fondo (fraz.)= " << ml.bkgFrac << " ± " << ml.bkgFracErr << "\n";
+        std::cout << "Correlazione = " << ml.corr << ",  eventi = " << ml.nEvents
+                  << ",  iterazioni = " << ml.iterations << "\n";
+        std::cout << "=======================================================\n";
+    } else {
+        std::cerr << "[ATTENZIONE] Il fit unbinned non converge.\n";
+    }
+
+#if defined(MULIFE_WITH_ROOT)
+    std::string out = opt.Get("out", "Mu_life_new.root");
+    TF1* fExpBkg = WriteLifetimeRoot(rep, out.c_str());
+    if (fExpBkg == nullptr) {
+        std::cerr << "[ERRORE] Impossibile creare il file " << out << "\n";
+        return 1;
+    }
+    std::cout << "\n================ RISULTATI FIT ================\n";
+    std::cout << "Tau (µ)  = " << fExpBkg->GetParameter(1) << " ± " << fExpBkg->GetParError(1) << " µs\n";
+    std::cout << "B (fondo)= " << fExpBkg->GetParameter(2) << " ± " << fExpBkg->GetParError(2) << " counts/bin\n";
+    std::cout << "==============================================\n";
+    std::cout << "[INFO] Risultati salvati in " << out << "\n";
+#endif
+    return 0;
+}
+
+// ---------------------------------------------------------------------
+//                                scan
+// ---------------------------------------------------------------------
+int RunScan(const char* path, const Options& opt)
+{
+    ScanGrid grid;
+    bool ok = true;
+    if (opt.Has("early")) ok = ok && ParseScanList(opt.Get("early", ""), grid.earlyStopMaxEvents);
+    if (opt.Has("final")) ok = ok && ParseScanList(opt.Get("final", ""), grid.finalStopMaxUs);
+    if (opt.Has("ebw"))   ok = ok && ParseScanList(opt.Get("ebw", ""), grid.earlyBlockWindow);
+    if (opt.Has("fbw"))   ok = ok && ParseScanList(opt.Get("fbw", ""), grid.finalBlockWindow);
+    if (opt.Has("tmin"))  ok = ok && ParseScanList(opt.Get("tmin", ""), grid.tmin);
+    if (opt.Has("tmax"))  ok = ok && ParseScanList(opt.Get("tmax", ""), grid.tmax);
+    if (!ok) {
+        std::cerr << "[ERRORE] Lista di valori non valida (\"v\", \"v1,v2\" o \"inizio:fine:passo\").\n";
+        return 1;
+    }
+
+    std::error_code ec;
+    std::vector<std::string> files;
+    if (std::filesystem::is_directory(path, ec)) files = FindTakes(path);
+    else                                         files.push_back(path);
+    if (files.empty()) {
+        std::cerr << "[ERRORE] Nessun file FIFOread_*.txt in " << path << "\n";
+        return 1;
+    }
+
+    if (!TickFromOptions(opt, NominalTick(files), grid.tickUs)) return 1;
+
+    // lettura e decodifica una volta per file, poi pairing e fit sulla griglia
+    std::vector<ScanPoint> points;
+    ScanInfo info;
+    if (!ScanLifetime(files, grid, points, (unsigned int)std::max(opt.GetInt("threads", 0), 0), &info)) {
+        std::cerr << "[ERRORE] Impossibile aprire il file " << info.failed << "\n";
+        return 1;
+    }
+
+    std::cout << "[INFO] File: " << info.files << ", righe: " << info.rows
+              << ", eventi: " << info.events << " (lettura " << info.readSec << " s)\n";
+    std::cout << "[INFO] Punti della griglia: " << points.size()
+              << " (pairing e fit " << info.scanSec << " s)\n\n";
+    WriteScanTable(std::cout, points);
+
+    if (opt.Has("csv")) {
+        std::string csv = opt.Get("csv", "scan.csv");
+        std::ofstream out(csv);
+        WriteScanTable(out, points, true);
+        if (!out) {
+            std::cerr << "[ERRORE] Impossibile scrivere il file " << csv << "\n";
+            return 1;
+        }
+        std::cout << "[INFO] Tabella salvata in " << csv << "\n";
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------
+//                             decaytime
+// ---------------------------------------------------------------------
+int RunDecayTime(const char* filename, const Options& opt)
+{
+    FixedHistogram      hist(100, 0.0, 20.0);
+    std::vector<double> dt;
+    std::size_t         rows = 0;
+
+    double tickUs = DECAYTIME_TICK_US;
+    if (!TickFromOptions(opt, DECAYTIME_TICK_US, tickUs)) return 1;
+
+    auto fill = [&](long long diff) {
+        double us = tickUs * (double)diff;
+        hist.Fill(us);
+        dt.push_back(us);
+    };
+    if (!StreamDecayTimes(filename, fill, &rows)) {
+        std::cerr << "[ERRORE] Impossibile aprire il file " << filename << "\n";
+        return 1;
+    }
+
+    std::cout << "[INFO] Righe lette: " << rows << ", coppie START → STOP: " << dt.size()
+              << " (in [0, 20] µs: " << hist.InRange() << ")\n";
+
+    LifetimeFitResult fit;
+    if (FitLifetimeUnbinned(dt, 0.0, 20.0, fit)) {
+        std::cout << "[INFO] Fit unbinned: tau = " << fit.tau << " ± " << fit.tauErr << " µs\n";
+    } else {
+        std::cout << "[WARN] Fit unbinned non convergente.\n";
+    }
+
+#if defined(MULIFE_WITH_ROOT)
+    std::string out = opt.Get("out", "DecayTime.root");
+    TFile fout(out.c_str(), "RECREATE");
+    TH1F* h = MakeTH1F(hist, "Results", "Decay time histogram");
+    h->GetXaxis()->SetTitle("Decay Time [us]");
+    h->GetYaxis()->SetTitle("Counts [pure]");
+    h->Write();
+    fout.Close();
+    std::cout << "[INFO] Risultati salvati in " << out << "\n";
+#else
+    (void)opt;
+#endif
+    return 0;
+}
+
+// ---------------------------------------------------------------------
+//                            calibration
+// ---------------------------------------------------------------------
+int RunCalibration(const char* filename, const Options& opt)
+{
+    CalibrationConfig config;
+    config.windowPeriods = (std::uint64_t)std::max(2, opt.GetInt("window", 32));
+
+    ClockCalibration cal;
+    if (!CalibrateClockFile(filename, cal, config)) {
+        if (cal.rows == 0) {
+            std::cerr << "[ERRORE] Impossibile aprire il file " << filename << "\n";
+        } else {
+            std::cerr << "[ERRORE] Nessun periodo del segnale di calibrazione trovato.\n";
+        }
+        return 1;
+    }
+
+    std::cout << "[INFO] Righe lette: " << cal.rows << "\n";
+    std::cout << "[INFO] Periodi misurati: " << cal.stats.n
+              << " (scartati fuori intervallo: " << cal.rejected << ")\n";
+    std::cout << "[INFO] Periodo medio: " << cal.periodMean << " ± " << cal.periodErr
+              << " tick (rms " << cal.periodRms << ")\n";
+    std::cout << cal.a << "+/-" << cal.aErr << "\n";
+    WriteDriftTable(std::cout, cal);
+
+    const std::string calib = opt.Get("calib", CLOCK_CALIBRATION_FILE);
+    if (!SaveClockCalibration(calib.c_str(), cal, filename, config.signalPeriodS)) {
+        std::cerr << "[ERRORE] Impossibile scrivere " << calib << "\n";
+        return 1;
+    }
+    std::cout << "[INFO] Calibrazione salvata in " << calib << "\n";
+
+#if defined(MULIFE_WITH_ROOT)
+    std::string out = opt.Get("out", "Calibration.root");
+    TFile fout(out.c_str(), "RECREATE");
+    TH1F* h = MakeTH1F(cal.period, "Period", "Histogram of period of calibration signal");
+    h->GetXaxis()->SetTitle("Period [digits]");
+    h->GetYaxis()->SetTitle("Counts [pure]");
+    h->Write();
+    fout.Close();
+    std::cout << "[INFO] Risultati salvati in " << out << "\n";
+#else
+    (void)opt;
+#endif
+    return 0;
+}
+
+// ---------------------------------------------------------------------
+//                               delay
+// ---------------------------------------------------------------------
+int RunDelay(const char* filename, const Options& opt)
+{
+    std::vector<unsigned int> CH, CT;
+    if (!LoadFifo(filename, CH, CT)) {
+        std::cerr << "[ERRORE] Impossibile aprire il file " << filename << "\n";
+        return 1;
+    }
+
+    FixedHistogram delay = ChannelDelay(CH, CT);
+    std::cout << "[INFO] Coppie canale 2 → 1: " << delay.Entries()
+              << " (nell'intervallo: " << delay.InRange() << ")\n";
+    std::cout << "[INFO] Ritardo medio: " << delay.Mean() << " tick (rms "
+              << delay.StdDev() << ")\n";
+
+#if defined(MULIFE_WITH_ROOT)
+    std::string out = opt.Get("out", "Delay.root");
+    TFile fout(out.c_str(), "RECREATE");
+    TH1F* h = MakeTH1F(delay, "Delay between 0 and 1", "Histogram of delay between channel");
+    h->GetXaxis()->SetTitle("Delay Time [a.u.]");
+    h->GetYaxis()->SetTitle("Counts [pure]");
+    h->Write();
+    fout.Close();
+    std::cout << "[INFO] Risultati salvati in " << out << "\n";
+#else
+    (void)opt;
+#endif
+    return 0;
+}
+
+// ---------------------------------------------------------------------
+//                                skew
+// ---------------------------------------------------------------------
+int RunSkew(const char* filename, const Options& opt)
+{
+    const int window = opt.GetInt("window", (int)SKEW_WINDOW_TICKS);
+    if (window <= 0) {
+        std::cerr << "[ERRORE] Finestra non valida: " << window << "\n";
+        return 1;
+    }
+
+    SkewMatrix  m;
+    std::size_t rows = 0;
+    if (!ChannelSkewFile(filename, m, window, &rows)) {
+        std::cerr << "[ERRORE] Impossibile aprire il file " << filename << "\n";
+        return 1;
+    }
+
+    std::cout << "[INFO] Righe lette: " << rows << "\n";
+    WriteSkewMatrix(std::cout, m);
+
+#if defined(MULIFE_WITH_ROOT)
+    std::string out = opt.Get("out", "Skew.root");
+    TFile fout(out.c_str(), "RECREATE");
+    for (int i = 0; i < SKEW_CHANNELS; ++i) {
+        for (int j = 0; j < SKEW_CHANNELS; ++j) {
+            if (m.Entries(i, j) == 0) continue;
+            std::string name  = std::string("Skew_") + SkewChannelName(i) + "_" + SkewChannelName(j);
+            std::string title = std::string("t(") + SkewChannelName(j) + ") - t(" + SkewChannelName(i) + ")";
+            TH1F* h = MakeTH1F(m.Histogram(i, j), name.c_str(), title.c_str());
+            h->GetXaxis()->SetTitle("Delay [ticks]");
+            h->GetYaxis()->SetTitle("Counts [pure]");
+            h->Write();
+        }
+    }
+    fout.Close();
+    std::cout << "[INFO] Risultati salvati in " << out << "\n";
+#endif
+    return 0;
+}
+
+// ---------------------------------------------------------------------
+//                              spectrum
+// ---------------------------------------------------------------------
+int RunSpectrum(const char* path, const Options& opt)
+{
+    std::error_code ec;
+    std::vector<std::string> files;
+    if (std::filesystem::is_directory(path, ec)) {
+        files = FindTakes(path, "");
+    } else {
+        files.push_back(path);
+    }
+    if (files.empty()) {
+        std::cerr << "[ERRORE] Nessun file wavedump in " << path << "\n";
+        return 1;
+    }
+
+    WaveConfig config;
+    config.baselineSamples      = opt.GetInt("baseline", config.baselineSamples);
+    config.threshold            = opt.GetDouble("threshold", config.threshold);
+    config.findPulses           = opt.Has("pulses");
+    config.pulses.hysteresis    = opt.GetInt("hysteresis", config.pulses.hysteresis);
+    config.pulses.baselineShift = opt.GetInt("shift", config.pulses.baselineShift);
+
+    if (config.baselineSamples <= 0) {
+        std::cerr << "[ERRORE] Campioni per la baseline non validi: " << config.baselineSamples << "\n";
+        return 1;
+    }
+    if (config.pulses.hysteresis < 0) {
+        std::cerr << "[ERRORE] Isteresi non valida: " << config.pulses.hysteresis << "\n";
+        return 1;
+    }
+    if (config.pulses.baselineShift < 0 || config.pulses.baselineShift > PULSE_MAX_SHIFT) {
+        std::cerr << "[ERRORE] Shift della baseline non valido: " << config.pulses.baselineShift
+                  << " (0 … " << PULSE_MAX_SHIFT << ")\n";
+        return 1;
+    }
+
+    WaveSpectra sp;
+    WaveInfo    info;
+    if (!AnalyzeWavedump(files, config, sp, (unsigned int)std::max(0, opt.GetInt("threads", 0)), &info)) {
+        std::cerr << "[ERRORE] Configurazione degli spettri non valida\n";
+        return 1;
+    }
+    if (info.failed == info.files) {
+        std::cerr << "[ERRORE] Impossibile aprire " << path << "\n";
+        return 1;
+    }
+
+    std::cout << "[INFO] File: " << info.files << " (non aperti: " << info.failed
+              << "), campioni: " << info.rows << "\n";
+    WriteWaveSummary(std::cout, sp);
+
+#if defined(MULIFE_WITH_ROOT)
+    std::string out = opt.Get("out", "Spectrum.root");
+    TFile fout(out.c_str(), "RECREATE");
+    for (int k = 0; k < WAVE_CHANNELS; ++k) {
+        std::string ch = "_CH" + std::to_string(k);
+        MakeTH1F(sp.amp[k], ("hAmp" + ch).c_str(), ("Ampiezza CH" + std::to_string(k)).c_str())->Write();
+        MakeTH1F(sp.area[k], ("hArea" + ch).c_str(), ("Area CH" + std::to_string(k)).c_str())->Write();
+    }
+    MakeTH1F(sp.sumAmp, "hAmp_sum", "Ampiezza, somma dei canali colpiti")->Write();
+    MakeTH1F(sp.sumArea, "hArea_sum", "Area, somma dei canali colpiti")->Write();
+    fout.Close();
+    std::cout << "[INFO] Risultati salvati in " << out << "\n";
+#endif
+    return 0;
+}
+
+// ---------------------------------------------------------------------
+//                              generate
+// ---------------------------------------------------------------------
+int RunGenerate(const char* filename, const Options& opt)
+{
+    SyntheticParams sp;
+    sp.tauUs          = opt.GetDouble("tau", sp.tauUs);
+    sp.muonRateHz     = opt.GetDouble("rate", sp.muonRateHz);
+    sp.decayFraction  = opt.GetDouble("decay", sp.decayFraction);
+    sp.accStartRateHz = opt.GetDouble("accstart", sp.accStartRateHz);
+    sp.accStopRateHz  = opt.GetDouble("accstop", sp.accStopRateHz);
+    sp.seed           = (std::uint64_t)std::strtoull(opt.Get("seed", "1").c_str(), nullptr, 10);
+
+    const double rows = opt.GetDouble("rows", 1e7);
+    if (!(sp.tauUs > 0.0) || !(rows >= 1.0)) {
+        std::cerr << "[ERRORE] Parametri non validi: tau = " << sp.tauUs
+                  << " µs, righe = " << rows << "\n";
+        return 1;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    SyntheticTruth truth;
+    if (!WriteSyntheticFifo(filename, sp, (std::uint64_t)rows, opt.Has("binary"), &truth)) {
+        std::cerr << "[ERRORE] Impossibile scrivere il file " << filename << "\n";
+        return 1;
+    }
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    std::error_code ec;
+    double mb = (double)std::filesystem::file_size(filename, ec) / 1e6;
+    std::cout << "[INFO] Righe scritte: " << truth.rows << " (" << mb << " MB, "
+              << mb / sec << " MB/s)\n";
+    std::cout << "[INFO] Reset: " << truth.resets << ", tempo simulato: "
+              << (double)truth.lastTicks * sp.tickUs * 1e-6 << " s\n";
+    std::cout << "[INFO] Muoni: " << truth.muons << ", decadimenti: " << truth.decays
+              << ", START accidentali: " << truth.accStarts
+              << ", STOP accidentali: " << truth.accStops << "\n";
+
+    if (!opt.Has("check")) return 0;
+
+    // Verifica: pairing e fit unbinned sul file appena scritto
+    LifetimeConfig config;
+    config.params.tmin = opt.GetDouble("tmin", 0.1);
+    config.params.tmax = opt.GetDouble("tmax", 20.0);
+    config.nThreads    = opt.GetInt("threads", 0);
+
+    LifetimeReport rep;
+    if (!AnalyzeLifetime(filename, config, rep) || !rep.mlOk) {
+        std::cerr << "[ERRORE] Il fit unbinned sul flusso generato non converge.\n";
+        return 1;
+    }
+    const double pull = (rep.ml.tau - sp.tauUs) / rep.ml.tauErr;
+    std::cout << "\n============ VERIFICA (fit unbinned) ============\n";
+    std::cout << "Coppie        = " << rep.take.dt_values.size() << "\n";
+    std::cout << "Tau iniettato = " << sp.tauUs << " µs\n";
+    std::cout << "Tau ricostr.  = " << rep.ml.tau << " ± " << rep.ml.tauErr
+              << " µs  (pull " << pull << ")\n";
+    std::cout << "=================================================\n";
+    return (std::fabs(pull) < 5.0) ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc < 3) {
+        Usage();
+        return 2;
+    }
+
+    const std::string cmd = argv[1];
+    const char* filename  = argv[2];
+
+    Options opt;
+    if (!ParseOptions(argc, argv, 3, opt)) {
+        Usage();
+        return 2;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    int rc;
+    if      (cmd == "lifetime")    rc = RunLifetime(filename, opt);
+    else if (cmd == "scan")        rc = RunScan(filename, opt);
+    else if (cmd == "decaytime")   rc = RunDecayTime(filename, opt);
+    else if (cmd == "calibration") rc = RunCalibration(filename, opt);
+    else if (cmd == "delay")       rc = RunDelay(filename, opt);
+    else if (cmd == "skew")        rc = RunSkew(filename, opt);
+    else if (cmd == "spectrum")    rc = RunSpectrum(filename, opt);
+    else if (cmd == "generate")    rc = RunGenerate(filename, opt);
+    else {
+        std::cerr << "[ERRORE] Comando sconosciuto: " << cmd << "\n";
+        Usage();
+        return 2;
+    }
+
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << "[INFO] Tempo di analisi: " << sec << " s\n";
+    return rc;
+}
@@ -0,0 +1,122 @@
+// =====================================================================
+//        TEST: ESITI DEGLI START UGUALI IN TUTTE LE MODALITÀ
+// =====================================================================
+//
+// Le coppie e i contatori PairingCounters non devono dipendere da come
+// il flusso è diviso: stesso risultato per il pairing in un blocco solo,
+// a blocchi di varie dimensioni (fino a un evento per blocco) e in
+// parallelo con 1, 2, 3 e 8 thread. Il confronto è fatto per
+// earlyStopMaxEvents = 0 (nessuno stop "immediato" ammesso, ogni START
+// di una serie è noEarlyStop), 1 e il valore di default.
+//
+// Flussi: i file dati sulla riga di comando (ad es. FIFOread_Take8.txt)
+// e un flusso sintetico con molti START accidentali, quindi molte serie
+// di START consecutivi.
+//
+//   ./PairingCountersTest data/Take/FIFOread_Take8.txt
+// =====================================================================
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "MuLife.h"
+
+using namespace mulife;
+
+namespace {
+
+std::string Format(const PairingCounters& c, std::size_t pairs)
+{
+    char buf[256];
+    std::snprintf(buf, sizeof(buf),
+                  "coppie %zu | start %zu, newStartEarly %zu, noEarlyStop %zu, newStartFinal %zu, "
+                  "noFinalStop %zu, outOfWindow %zu, accepted %zu, unfinished %zu",
+                  pairs, c.starts, c.newStartEarly, c.noEarlyStop, c.newStartFinal,
+                  c.noFinalStop, c.outOfWindow, c.accepted, c.unfinished);
+    return buf;
+}
+
+// Pairing sequenziale, decodifica e pairing a blocchi di chunk righe
+std::string PairSerial(const std::vector<unsigned int>& CH, const std::vector<unsigned int>& CT,
+                       const PairingParams& params, std::size_t chunk)
+{
+    FifoDecoder            decoder;
+    PairingEngine          engine(params);
+    EventStore             events;
+    std::vector<DecayPair> pairs;
+    for (std::size_t row = 0; row < CH.size(); row += chunk) {
+        const std::size_t n = std::min(chunk, CH.size() - row);
+        events.clear();
+        decoder.Decode(CH.data() + row, CT.data() + row, n, events);
+        engine.Process(events, pairs);
+    }
+    engine.Finish(pairs);
+    return Format(engine.Counters(), pairs.size());
+}
+
+std::string PairParallel(const std::vector<unsigned int>& CH, const std::vector<unsigned int>& CT,
+                         const PairingParams& params, unsigned int nThreads)
+{
+    PairingSummary         summary;
+    std::vector<DecayPair> pairs;
+    PairFifoParallel(CH, CT, params, pairs, &summary, nThreads);
+    return Format(summary.counters, pairs.size());
+}
+
+// Ritorna il numero di modalità diverse dal riferimento (un blocco solo)
+int CheckStream(const char* name, const std::vector<unsigned int>& CH,
+                const std::vector<unsigned int>& CT)
+{
+    int failed = 0;
+    for (int early : {0, 1, EARLY_STOP_MAX_TICKS}) {
+        PairingParams params;
+        params.earlyStopMaxEvents = early;
+
+        const std::string ref = PairSerial(CH, CT, params, CH.size());
+        std::printf("%s, early %d: %s\n", name, early, ref.c_str());
+
+        auto check = [&](const char* mode, std::size_t value, const std::string& got) {
+            if (got == ref) return;
+            std::printf("[ERRORE] %s, early %d, %s %zu: %s\n", name, early, mode, value, got.c_str());
+            ++failed;
+        };
+        for (std::size_t chunk : {4096, 1000, 37, 1}) check("blocchi da", chunk, PairSerial(CH, CT, params, chunk));
+        for (unsigned int t : {1u, 2u, 3u, 8u})      check("thread", t, PairParallel(CH, CT, params, t));
+    }
+    return failed;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int failed = 0;
+
+    for (int k = 1; k < argc; ++k) {
+        std::vector<unsigned int> CH, CT;
+        if (!LoadFifo(argv[k], CH, CT)) {
+            std::printf("[ERRORE] Impossibile aprire il file %s\n", argv[k]);
+            ++failed;
+            continue;
+        }
+        failed += CheckStream(argv[k], CH, CT);
+    }
+
+    SyntheticParams sp;
+    sp.accStartRateHz = 2e4;   // START accidentali a pochi tick l'uno dall'altro
+    sp.muonRateHz     = 1e4;
+    sp.accStopRateHz  = 5e3;
+    SyntheticFifo gen(sp);
+    std::vector<unsigned int> CH, CT;
+    gen.Next(CH, CT, 200000);
+    failed += CheckStream("sintetico", CH, CT);
+
+    if (failed != 0) {
+        std::printf("[ERRORE] %d modalità con contatori diversi\n", failed);
+        return 1;
+    }
+    std::printf("[OK] Contatori uguali in tutte le modalità\n");
+    return 0;
+}
@@ -0,0 +1,162 @@
+// =====================================================================
+//        TEST: RICERCA DEGLI IMPULSI, SCALARE E AVX2 UGUALI
+// =====================================================================
+//
+// PulseFinder deve dare esattamente gli stessi impulsi (tutti i campi di
+// WaveHit) con il codice scalare e con quello AVX2, e non deve
+// dipendere da come i campioni di un record sono divisi tra le chiamate
+// a Process(). Il confronto è fatto per baselineShift da 0 a 30 e per
+// diversi valori di isteresi, su:
+//
+//   - i file wavedump sulla riga di comando (ad es. PlotData.txt);
+//   - record sintetici con rumore e molti impulsi (seme fisso), passati
+//     a blocchi di lunghezza casuale.
+//
+// Senza AVX2 (CPU o compilatore) le due versioni coincidono per
+// costruzione e il test controlla solo la divisione a blocchi.
+//
+//   ./WavePulsesTest data/wavedump/PlotData.txt
+// =====================================================================
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "WavedumpSpectrum.h"
+#include "WavePulses.h"
+
+using namespace mulife;
+
+namespace {
+
+bool SameHit(const WaveHit& a, const WaveHit& b)
+{
+    return a.channel == b.channel && a.time == b.time && a.start == b.start &&
+           a.peak == b.peak && a.length == b.length && a.amplitude == b.amplitude &&
+           a.area == b.area && a.baseline == b.baseline && a.closed == b.closed;
+}
+
+// Impulsi di un record passato a PulseFinder a blocchi di lunghezza
+// casuale (chunks vuoto: tutto insieme)
+std::vector<WaveHit> Find(const std::vector<std::int32_t>& x, const PulseConfig& c, bool useSimd,
+                          const std::vector<std::size_t>& chunks)
+{
+    const std::size_t n = x.size() / PULSE_CHANNELS;
+    std::vector<WaveHit> out;
+    PulseFinder finder(c, useSimd);
+    std::size_t i = 0;
+    for (std::size_t len : chunks) {
+        len = std::min(len, n - i);
+        finder.Process(x.data() + PULSE_CHANNELS * i, len, out);
+        i += len;
+    }
+    finder.Process(x.data() + PULSE_CHANNELS * i, n - i, out);
+    finder.Finish(out);
+    return out;
+}
+
+// Confronta scalare e AVX2, in un blocco solo e a blocchi; ritorna il
+// numero di confronti falliti
+int CheckRecord(const char* name, std::size_t record, const std::vector<std::int32_t>& x,
+                const PulseConfig& c, std::mt19937_64& rng, std::size_t& hits)
+{
+    std::vector<std::size_t> chunks;
+    std::uniform_int_distribution<std::size_t> len(1, 700);
+    for (std::size_t total = 0; total < x.size() / PULSE_CHANNELS;) {
+        chunks.push_back(len(rng));
+        total += chunks.back();
+    }
+
+    const std::vector<WaveHit> ref = Find(x, c, false, {});
+    hits += ref.size();
+
+    int failed = 0;
+    const struct { bool simd; bool chunked; } modes[] = {{true, false}, {false, true}, {true, true}};
+    for (const auto& m : modes) {
+        const std::vector<WaveHit> got = Find(x, c, m.simd, m.chunked ? chunks : std::vector<std::size_t>());
+        bool same = got.size() == ref.size();
+        for (std::size_t k = 0; same && k < ref.size(); ++k) same = SameHit(got[k], ref[k]);
+        if (same) continue;
+        std::printf("[ERRORE] %s, record %zu, shift %d, isteresi %d, %s%s: %zu impulsi invece di %zu\n",
+                    name, record, c.baselineShift, c.hysteresis, m.simd ? "AVX2" : "scalare",
+                    m.chunked ? " a blocchi" : "", got.size(), ref.size());
+        ++failed;
+    }
+    return failed;
+}
+
+// Record sintetico: baseline diversa per canale, rumore gaussiano,
+// impulsi negativi di ampiezza e durata casuali
+std::vector<std::int32_t> SyntheticRecord(std::mt19937_64& rng, std::size_t n)
+{
+    std::normal_distribution<double>       noise(0.0, 20.0);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::vector<std::int32_t> x(PULSE_CHANNELS * n);
+    for (int k = 0; k < PULSE_CHANNELS; ++k) {
+        const double base = 10000.0 + 2000.0 * k;
+        double pulse = 0.0;
+        for (std::size_t i = 0; i < n; ++i) {
+            if (uniform(rng) < 0.01) pulse += 200.0 + 3000.0 * uniform(rng);
+            pulse *= 0.9;
+            x[PULSE_CHANNELS * i + k] = (std::int32_t)(base - pulse + noise(rng));
+        }
+    }
+    return x;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const int HYSTERESIS[] = {0, 10, 25, 60};
+
+    std::mt19937_64 rng(12345);
+    int             failed = 0;
+    std::size_t     hits   = 0;
+
+    for (int a = 1; a < argc; ++a) {
+        WavedumpReader in;
+        if (!in.Open(argv[a])) {
+            std::printf("[ERRORE] Impossibile aprire il file %s\n", argv[a]);
+            ++failed;
+            continue;
+        }
+        WaveRecord  rec;
+        std::size_t r = 0;
+        while (in.Next(rec)) {
+            for (int shift = 0; shift <= PULSE_MAX_SHIFT; ++shift) {
+                for (int hyst : HYSTERESIS) {
+                    PulseConfig c;
+                    c.baselineShift = shift;
+                    c.hysteresis    = hyst;
+                    failed += CheckRecord(argv[a], r, rec.samples, c, rng, hits);
+                }
+            }
+            ++r;
+        }
+    }
+
+    for (std::size_t r = 0; r < 300; ++r) {
+        const std::vector<std::int32_t> x = SyntheticRecord(rng, 500 + 17 * r);
+        PulseConfig c;
+        c.baselineShift = (int)(r % (PULSE_MAX_SHIFT + 1));
+        c.hysteresis    = HYSTERESIS[r % 4];
+        c.warmupSamples = (int)(r % 70);
+        failed += CheckRecord("sintetico", r, x, c, rng, hits);
+    }
+
+#if defined(MULIFE_AVX2_DISPATCH)
+    std::printf("[INFO] AVX2 %s\n", detail::UsePulsesAVX2() ? "disponibile" : "non disponibile: solo codice scalare");
+#else
+    std::printf("[INFO] Compilato senza AVX2: solo codice scalare\n");
+#endif
+    std::printf("[INFO] Impulsi confrontati: %zu\n", hits);
+    if (failed != 0) {
+        std::printf("[ERRORE] %d confronti con impulsi diversi\n", failed);
+        return 1;
+    }
+    std::printf("[OK] Impulsi uguali (scalare, AVX2, a blocchi)\n");
+    return 0;
+}